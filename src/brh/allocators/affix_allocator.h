@@ -2,8 +2,10 @@
 #define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_AFFIX_ALLOCATOR_H
 
 #include <type_traits>
+#include <cstring>
 
 #include "common/common_types.h"
+#include "traits/traits.h"
 
 namespace brh {
 	namespace allocators {
@@ -17,6 +19,32 @@ constexpr void voidSafePlacementNew(void * destination) {
 template <>
 constexpr void voidSafePlacementNew<void>(void *) {}
 
+
+/// Holds a bitwise copy of an affix while its block is being resized.
+template <class T>
+class AffixStash
+{
+	public:
+		void load(char const * source) {
+			std::memcpy(&data_, source, sizeof(T));
+		}
+
+		void store(char * destination) const {
+			std::memcpy(destination, &data_, sizeof(T));
+		}
+
+	private:
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type data_;
+};
+
+template <>
+class AffixStash<void>
+{
+	public:
+		void load (char const *) {}
+		void store(char       *) const {}
+};
+
 template <class t_Allocator, class Prefix, class Suffix = void>
 class AffixAllocator : private t_Allocator
 {
@@ -48,6 +76,21 @@ class AffixAllocator : private t_Allocator
 			Allocator::deallocate(handle);
 		}
 
+		/// The prefix moves along with the data, the suffix is carried over
+		/// to the new end of the block.
+		bool reallocate(Handle & handle, SizeType newObjectSize) {
+			return resize(handle, [&](Handle & inner) {
+				return traits::reallocate(getAllocator(), inner,
+				                          calcFullSize(newObjectSize));
+			});
+		}
+
+		bool expand(Handle & handle, SizeType amount) {
+			return resize(handle, [&](Handle & inner) {
+				return traits::expand(getAllocator(), inner, amount);
+			});
+		}
+
 		SizeType calcFullSize(SizeType objectSize) const {
 			return (objectSize + getExtraSize());
 		}
@@ -65,6 +108,26 @@ class AffixAllocator : private t_Allocator
 		}
 
 	private:
+		Allocator & getAllocator() { return *this; }
+
+		template <class Function>
+		bool resize(Handle & handle, Function resizeInner) {
+			Handle inner {handle.getCharPtr() - getPrefixSize(), handle.getSize()};
+
+			AffixStash<Suffix> suffix;
+			suffix.load(inner.getEndChar() - getSuffixSize());
+
+			if (!resizeInner(inner))
+				return false;
+
+			suffix.store(inner.getEndChar() - getSuffixSize());
+
+			handle.setPtr(inner.getCharPtr() + getPrefixSize());
+			handle.setSize(inner.getSize());
+
+			return true;
+		}
+
 		template <class T>
 		constexpr SizeType getSize() const {
 			if (std::is_void<T>::value)
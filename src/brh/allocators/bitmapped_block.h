@@ -1,32 +1,29 @@
 #ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_BITMAPPED_BLOCK_H
 #define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_BITMAPPED_BLOCK_H
 
-#define BRH_CPP_ALLOCATORS_BITMAPPED_BLOCK_NEXT_BYTE_ALLOCATION
-#define BRH_CPP_ALLOCATORS_BITMAPPED_BLOCK_NEXT_BYTE_DEALLOCATION
-
-//#define BRH_CPP_ALLOCATORS_MULTITHREADED
-//#define BRH_CPP_ALLOCATORS_BITMAPPED_BLOCK_3_STAGE_ALLOCATION
-
 #include <iostream>
 #include <array>
 #include <vector>
 #include <bitset>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <climits>
 #include <limits>
 #include <utility>
 #include <cassert>
 #include <functional>
+#include <type_traits>
 
 #include <supports/round_up_to_multiple.h>
 #include <supports/calc_lcm.h>
 
 #include "traits/traits.h"
 #include "common/common_types.h"
+#include "common/fast_divisor.h"
 #include "wrappers/allocator_wrapper.h"
 
-#include "multithread/thread.h"
+#include "multithread/lock.h"
 
 namespace brh {
 	namespace allocators {
@@ -54,6 +51,14 @@ class BasicArrayElement {
 			data_ &= ~(1 << place);
 		}
 
+		void setMask(DataType mask) {
+			data_ |= mask;
+		}
+
+		void unsetMask(DataType mask) {
+			data_ &= ~mask;
+		}
+
 
 	private:
 		DataType data_;
@@ -72,6 +77,15 @@ unsigned int arrayElementSize     {sizeof(ArrayElement)};
 static constexpr
 unsigned int arrayElementSizeBits {arrayElementSize * CHAR_BIT};
 
+/// Meta data is scanned in words of this type where possible.
+using MetaWord = unsigned long long;
+
+static constexpr
+SizeType metaWordBytes {sizeof(MetaWord)};
+
+static constexpr
+SizeType metaWordBits  {metaWordBytes * CHAR_BIT};
+
 template <std::size_t alignment>
 class alignas(alignment) AlignedType :
 	public std::array<ArrayElement, alignment / arrayElementSize> {
@@ -81,7 +95,348 @@ class alignas(alignment) AlignedType :
 };
 
 
-template <class t_Policy>
+/// A lock followed by padding, so that whatever comes after the allocator,
+/// in an array or a struct, stays off the line of the lock even where the
+/// allocator itself isn't aligned to a line.
+template <class Lock, std::size_t padding>
+class TrailingPaddedLock : public Lock {
+	private:
+		char padding_[padding];
+};
+
+template <class Lock, std::size_t padding>
+using PaddedLockType = typename std::conditional<
+	(padding > 1), TrailingPaddedLock<Lock, padding>, Lock
+>::type;
+
+
+/// A point in time summary of how fragmented an arena is.
+/// Run lengths are in blocks.
+struct FragmentationSnapshot {
+	static constexpr std::size_t histogramSize {sizeof(SizeType) * CHAR_BIT};
+
+	SizeType blockSize;
+	SizeType blockCount;
+	SizeType freeBlocks;
+	SizeType freeRuns;
+	SizeType largestFreeRun;
+
+	/// Element i counts the free runs with a length in [2^i, 2^(i+1)).
+	std::array<SizeType, histogramSize> freeRunHistogram;
+
+	/// Occupied blocks of each region, every region holds regionBlocks
+	/// blocks except possibly the last.
+	std::vector<SizeType> regionOccupancy;
+	SizeType              regionBlocks;
+
+	/// 0 when all free space is a single run, approaches 1 as the free
+	/// space is split into runs that are small compared to the total.
+	double calcExternalFragmentation() const {
+		if (freeBlocks == 0)
+			return 0;
+
+		return 1.0 - static_cast<double>(largestFreeRun) / freeBlocks;
+	}
+};
+
+
+/// Takes the first free run of blocks at or after begin and before end that
+/// is long enough.
+template <class Allocator>
+bool findFirstFit(Allocator const & allocator,
+                  SizeType          begin,
+                  SizeType          end,
+                  SizeType          blocksRequired,
+                  SizeType        & outIndex) {
+	SizeType start;
+	SizeType length;
+
+	while (allocator.findFreeRun(begin, end, blocksRequired, start, length)) {
+		if (length == blocksRequired) {
+			outIndex = start;
+			return true;
+		}
+
+		begin = start + length;
+	}
+
+	return false;
+}
+
+/// Placement strategies choose the free run of blocks that an allocation
+/// takes. They are told about every allocation and deallocation so that
+/// they can keep hints, and are reset by deallocateAll.
+
+/// Always searches from the first block. Keeps the start of the arena
+/// packed at the cost of rescanning it.
+class FirstFit {
+	public:
+		template <class Allocator>
+		bool find(Allocator const & allocator,
+		          SizeType          blocksRequired,
+		          SizeType        & outIndex) const {
+			return findFirstFit(
+				allocator, 0, allocator.getBlockCount(), blocksRequired, outIndex
+			);
+		}
+
+		SizeType getHint(SizeType) const { return 0; }
+
+		void onAllocate(SizeType, SizeType, SizeType) {}
+		void onDeallocate(SizeType, SizeType) {}
+		void reset() {}
+};
+
+/// Searches from the end of the last allocation, or from the start of the
+/// last deallocation, and wraps around.
+class NextFit {
+	public:
+		template <class Allocator>
+		bool find(Allocator const & allocator,
+		          SizeType          blocksRequired,
+		          SizeType        & outIndex) const {
+			auto const blockCount = allocator.getBlockCount();
+
+			return (
+				findFirstFit(allocator, hint_, blockCount, blocksRequired, outIndex) ||
+				findFirstFit(allocator, 0,     hint_,      blocksRequired, outIndex)
+			);
+		}
+
+		SizeType getHint(SizeType) const { return hint_; }
+
+		void onAllocate(SizeType firstIndex,
+		                SizeType blocks,
+		                SizeType blockCount) {
+			hint_ = firstIndex + blocks;
+
+			if (hint_ == blockCount)
+				hint_ = 0;
+		}
+
+		void onDeallocate(SizeType firstIndex, SizeType) {
+			hint_ = firstIndex;
+		}
+
+		void reset() { hint_ = 0; }
+
+
+	private:
+		SizeType hint_ {0};
+};
+
+/// Looks at up to window free runs that are long enough, starting from the
+/// end of the last allocation, and takes the shortest of them. Stops early
+/// on an exact fit.
+template <SizeType window = 8>
+class BestFit {
+	static_assert(window > 0, "BestFit needs a window of at least 1");
+
+	public:
+		template <class Allocator>
+		bool find(Allocator const & allocator,
+		          SizeType          blocksRequired,
+		          SizeType        & outIndex) const {
+			auto const blockCount = allocator.getBlockCount();
+
+			Candidate best {blocksRequired};
+
+			if (!findBest(allocator, hint_, blockCount, best))
+				findBest(allocator, 0, hint_, best);
+
+			if (best.count == 0)
+				return false;
+
+			outIndex = best.index;
+			return true;
+		}
+
+		SizeType getHint(SizeType) const { return hint_; }
+
+		void onAllocate(SizeType firstIndex,
+		                SizeType blocks,
+		                SizeType blockCount) {
+			hint_ = firstIndex + blocks;
+
+			if (hint_ == blockCount)
+				hint_ = 0;
+		}
+
+		void onDeallocate(SizeType, SizeType) {}
+
+		void reset() { hint_ = 0; }
+
+
+	private:
+		struct Candidate {
+			SizeType blocksRequired;
+			SizeType index  {0};
+			SizeType length {0};
+			SizeType count  {0};
+		};
+
+		/// @return Whether the search is over, either because of an exact
+		///         fit or because the window is used up.
+		template <class Allocator>
+		static bool findBest(Allocator const & allocator,
+		                     SizeType          begin,
+		                     SizeType          end,
+		                     Candidate       & best) {
+			auto const blockCount = allocator.getBlockCount();
+
+			SizeType start;
+			SizeType length;
+
+			while (allocator.findFreeRun(begin, end, blockCount, start, length)) {
+				if (length >= best.blocksRequired &&
+				    (best.count == 0 || length < best.length)) {
+					best.index  = start;
+					best.length = length;
+				}
+
+				if (length >= best.blocksRequired) {
+					++best.count;
+
+					if (length == best.blocksRequired || best.count == window)
+						return true;
+				}
+
+				begin = start + length;
+			}
+
+			return false;
+		}
+
+		SizeType hint_ {0};
+};
+
+/// Next fit with a separate hint for every size bucket, so that small
+/// allocations don't drag the hint of large ones into fragmented space.
+/// Bucket i holds the allocations of [2^i, 2^(i+1)) blocks, the last
+/// bucket holds everything larger.
+template <SizeType bucketCount = 8>
+class SegregatedHints {
+	static_assert(bucketCount > 0, "SegregatedHints needs at least 1 bucket");
+
+	public:
+		template <class Allocator>
+		bool find(Allocator const & allocator,
+		          SizeType          blocksRequired,
+		          SizeType        & outIndex) const {
+			auto const blockCount = allocator.getBlockCount();
+			auto const hint       = getHint(blocksRequired);
+
+			return (
+				findFirstFit(allocator, hint, blockCount, blocksRequired, outIndex) ||
+				findFirstFit(allocator, 0,    hint,       blocksRequired, outIndex)
+			);
+		}
+
+		SizeType getHint(SizeType blocksRequired) const {
+			return hints_[getBucket(blocksRequired)];
+		}
+
+		void onAllocate(SizeType firstIndex,
+		                SizeType blocks,
+		                SizeType blockCount) {
+			auto & hint = hints_[getBucket(blocks)];
+
+			hint = firstIndex + blocks;
+
+			if (hint == blockCount)
+				hint = 0;
+		}
+
+		/// The freed run can hold another allocation of the same bucket.
+		void onDeallocate(SizeType firstIndex, SizeType blocks) {
+			hints_[getBucket(blocks)] = firstIndex;
+		}
+
+		void reset() { hints_.fill(0); }
+
+
+	private:
+		static SizeType getBucket(SizeType blocks) {
+			SizeType bucket {0};
+
+			while (blocks > 1 && bucket + 1 < bucketCount) {
+				blocks >>= 1;
+				++bucket;
+			}
+
+			return bucket;
+		}
+
+		std::array<SizeType, bucketCount> hints_ {};
+};
+
+
+/// Size recovery keeps what is needed to find the size of a block from its
+/// pointer alone, so that blocks can be freed without their size.
+
+/// Keeps nothing, blocks must be deallocated with their size.
+class NoSizeRecovery {
+	public:
+		static constexpr bool enabled {false};
+
+		void setRunEnd(SizeType) {}
+		void unsetRunEnd(SizeType) {}
+		void reset(SizeType) {}
+};
+
+/// A second bitmap on the heap with the bit of the last block of every
+/// allocation set. Costs a bit per block and a bit write per allocation
+/// and deallocation.
+class RunEndBitmap {
+	public:
+		static constexpr bool enabled {true};
+
+		void setRunEnd(SizeType blockIndex) {
+			words_[blockIndex / metaWordBits] |= getBit(blockIndex);
+		}
+
+		void unsetRunEnd(SizeType blockIndex) {
+			words_[blockIndex / metaWordBits] &= ~getBit(blockIndex);
+		}
+
+		void reset(SizeType blockCount) {
+			words_.assign(
+				supports::roundUpToMultiple(blockCount, metaWordBits) /
+					metaWordBits,
+				0
+			);
+		}
+
+		/// @return The last block of the allocation that the block at
+		///         blockIndex belongs to.
+		SizeType findRunEnd(SizeType blockIndex) const {
+			auto index = blockIndex / metaWordBits;
+			auto word  = words_[index] & (~MetaWord {0} << (blockIndex % metaWordBits));
+
+			while (word == 0)
+				word = words_[++index];
+
+			return index * metaWordBits + __builtin_ctzll(word);
+		}
+
+		SizeType getMemoryUsage() const {
+			return words_.size() * metaWordBytes;
+		}
+
+
+	private:
+		static MetaWord getBit(SizeType blockIndex) {
+			return MetaWord {1} << (blockIndex % metaWordBits);
+		}
+
+		std::vector<MetaWord> words_;
+};
+
+
+template <class t_Policy,
+          class t_Placement    = NextFit,
+          class t_SizeRecovery = NoSizeRecovery,
+          class t_Lock         = multithread::DefaultLock>
 class alignas(t_Policy::alignment)
 Allocator : private t_Policy {
 	private:
@@ -89,29 +444,34 @@ Allocator : private t_Policy {
 		using ConstPointer = ArrayElement const *;
 
 	public:
-		using Policy = t_Policy;
-		using Handle = RawBlock;
+		using Policy    = t_Policy;
+		using Placement    = t_Placement;
+		using SizeRecovery = t_SizeRecovery;
+		using Lock         = t_Lock;
+		using Handle       = RawBlock;
 
 		friend void swap(Allocator & first, Allocator & second) {
 			using std::swap;
 
-			swap(static_cast<Policy&>(first),  static_cast<Policy&>(second));
-			swap(first.allocateByteHint_,      second.allocateByteHint_);
+			swap(static_cast<Policy&>(first), static_cast<Policy&>(second));
+			swap(first.placement_,            second.placement_);
+			swap(first.sizeRecovery_,         second.sizeRecovery_);
 		}
 
 		Allocator() : Allocator(Policy()) {}
 
-		Allocator(Policy policy) :
-			Policy            (std::move(policy)),
-			allocateByteHint_ {0} {
+		Allocator(Policy       policy,
+		          Placement    placement    = Placement(),
+		          SizeRecovery sizeRecovery = SizeRecovery()) :
+			Policy        (std::move(policy)),
+			placement_    (std::move(placement)),
+			sizeRecovery_ (std::move(sizeRecovery)) {
 
 			deallocateAll();
 
-			// Make sure the array is aligned correctly.
+			// Make sure the blocks are aligned correctly.
 			assert(
-				reinterpret_cast<uintptr_t>(
-				       Policy::getArray().data()
-				) % Policy::alignment == 0
+				reinterpret_cast<uintptr_t>(getStorage()) % Policy::alignment == 0
 			);
 		}
 
@@ -128,9 +488,8 @@ Allocator : private t_Policy {
 				return getAttributes().getBlockSize();
 			}
 			else {
-				return supports::roundUpToMultiple(
-					desiredSize, getAttributes().getBlockSize()
-				);
+				return getAttributes().calcBlocksRequired(desiredSize) *
+				       getAttributes().getBlockSize();
 			}
 		}
 
@@ -138,11 +497,42 @@ Allocator : private t_Policy {
 			return Policy::getAttributes().getStorageSize();
 		}
 
+		constexpr SizeType getBlockCount() const {
+			return getAttributes().getBlockCount();
+		}
+
+		/// The alignment that every block has without allocateAligned.
+		constexpr SizeType getBlockAlignment() const {
+			return getAttributes().getBlockAlignment();
+		}
+
+		/// Finds the first free block at or after from and before end.
+		/// The length of the free run starting there is measured up to
+		/// maxLength blocks, and may reach past end.
+		bool findFreeRun(SizeType   from,
+		                 SizeType   end,
+		                 SizeType   maxLength,
+		                 SizeType & outStart,
+		                 SizeType & outLength) const {
+			auto const start = findMetaBit(from, end, false);
+
+			if (start >= end)
+				return false;
+
+			auto const blockCount = getBlockCount();
+			auto const limit      = (maxLength < blockCount - start ?
+			                         start + maxLength : blockCount);
+
+			outStart  = start;
+			outLength = findMetaBit(start, limit, true) - start;
+			return true;
+		}
+
 		template <class T>
 		void printBits() const {
 			printMeta();
 
-			for (std::size_t i {0}; i < Policy::getBlockCount(); ++i) {
+			for (std::size_t i {0}; i < getAttributes().getBlockCount(); ++i) {
 				std::cout << ' ' << *reinterpret_cast<T const *>(getBlockPtr(i));
 			}
 
@@ -155,106 +545,184 @@ Allocator : private t_Policy {
 			}
 		}
 
-		SizeType countUsedBlocks() {
+		SizeType countUsedBlocks() const {
 			SizeType count {0};
-			for (SizeType i {0}; i < Policy::getBlockCount(); ++i) {
-				if (getMetaBit(i) == 1)
-					++count;
+			auto const end = getMetaWordCount();
+
+			for (SizeType i {0}; i < end; ++i) {
+				count += __builtin_popcountll(loadMetaWord(i) & getValidMask(i));
 			}
 
 			return count;
 		}
 
-		// Allocate
-		Handle allocateInBlocks(SizeType blockCount) {
-			return allocate(getAttributes().getBlockSize() * blockCount);
-		}
+		/// Scans the meta data a word at a time. The words are copied under
+		/// the allocation lock in chunks of snapshotChunkWords, so allocations
+		/// only wait for one chunk at a time. The chunks are consistent on
+		/// their own, but not with each other while other threads allocate.
+		///
+		/// @param regionCount The amount of regions to report occupancy for,
+		///                    region sizes are rounded up to 64 blocks.
+		FragmentationSnapshot takeSnapshot(SizeType regionCount = 1) const {
+			FragmentationSnapshot snapshot {};
 
-		Handle allocate(SizeType size) {
-			SizeType blocksRequired;
-			allocationSetup(size, blocksRequired);
+			auto const blockCount = getAttributes().getBlockCount();
 
+			snapshot.blockSize  = getAttributes().getBlockSize();
+			snapshot.blockCount = blockCount;
 
-			bool     finished;
-			auto     byte = allocateByteHint_;
-			ByteType bit  = 0;
+			if (regionCount == 0)
+				regionCount = 1;
 
-			do {
-				if (findAllocationFromLocation(finished, byte, bit, blocksRequired))
-					return {guaranteedAllocate(byte, bit, blocksRequired), size};
-			} while (!finished);
+			snapshot.regionBlocks = supports::roundUpToMultiple(
+				supports::roundUpToMultiple(blockCount, regionCount) / regionCount,
+				metaWordBits
+			);
+			snapshot.regionOccupancy.assign(
+				supports::roundUpToMultiple(blockCount, snapshot.regionBlocks) /
+					snapshot.regionBlocks,
+				0
+			);
 
+			SizeType run {0};
 
-			byte = 0;
-			bit  = 0;
-			auto end = allocateByteHint_;
+			auto closeRun = [&]() {
+				if (run == 0)
+					return;
 
-			do {
-				if (findAllocationFromLocation(finished, byte, bit, blocksRequired))
-					return {guaranteedAllocate(byte, bit, blocksRequired), size};
-			} while (byte < end);
+				++snapshot.freeRuns;
+				snapshot.freeBlocks += run;
+				++snapshot.freeRunHistogram[calcLog2(run)];
 
+				if (run > snapshot.largestFreeRun)
+					snapshot.largestFreeRun = run;
 
-			return Handle::makeNullBlock();
-		}
+				run = 0;
+			};
 
-		Handle allocateAligned(SizeType size, SizeType alignment) {
-			SizeType blocksRequired;
-			allocationSetup(size, blocksRequired);
+			auto const end = getMetaWordCount();
 
+			MetaWord words[snapshotChunkWords];
 
-			auto lcm = supports::calcLcm(
-				getAttributes().getBlockSize(), alignment
-			);
+			for (SizeType i {0}; i < end; ++i) {
+				auto const chunkIndex = i % snapshotChunkWords;
 
-			// The distance between valid blocks.
-			auto step = lcm / getAttributes().getBlockSize();
+				if (chunkIndex == 0) {
+					auto const lock = makeAllocationLock();
 
-			auto hintPtr    = getBlockPtr(getBlockIndex(allocateByteHint_, 0));
-			auto startPtr   = findNextAligned(hintPtr, alignment);
-			auto startIndex = getBlockIndex(startPtr);
+					for (SizeType j {i}; j < end && j - i < snapshotChunkWords; ++j)
+						words[j - i] = loadMetaWord(j);
+				}
 
-			bool finished;
-			auto byte = getMetaIndex   (startIndex);
-			auto bit  = getMetaBitIndex(startIndex);
+				// Bits past the last block read as occupied.
+				auto const used = words[chunkIndex] | ~getValidMask(i);
 
+				snapshot.regionOccupancy[i * metaWordBits / snapshot.regionBlocks] +=
+					__builtin_popcountll(used & getValidMask(i));
 
-			do {
-				if (findAllocationFromLocation(finished, byte, bit, blocksRequired))
-					return {guaranteedAllocate(byte, bit, blocksRequired), size};
+				if (used == 0) {
+					run += metaWordBits;
+					continue;
+				}
 
-				alignLocation(byte, bit, startIndex, step);
+				SizeType position {0};
 
-			} while (!finished);
+				while (position < metaWordBits) {
+					auto const rest = used >> position;
+					auto const left = metaWordBits - position;
 
+					if ((rest & 1) == 0) {
+						SizeType length {
+							rest == 0 ? left :
+								static_cast<SizeType>(__builtin_ctzll(rest))
+						};
 
-			startPtr = findNextAligned(Policy::getElements(), alignment);
-			startIndex = getBlockIndex(startPtr);
+						run      += length;
+						position += length;
+					}
 
-			byte = getMetaIndex   (startIndex);
-			bit  = getMetaBitIndex(startIndex);
-			auto end = startIndex;
+					else {
+						closeRun();
 
-			do {
-				if (findAllocationFromLocation(finished, byte, bit, blocksRequired))
-					return {guaranteedAllocate(byte, bit, blocksRequired), size};
+						SizeType length {
+							static_cast<SizeType>(__builtin_ctzll(~rest))
+						};
 
-				alignLocation(byte, bit, startIndex, step);
+						position += (length < left ? length : left);
+					}
+				}
+			}
 
-			} while (byte < end);
+			closeRun();
 
+			return snapshot;
+		}
+
+		// Allocate
+		Handle allocateInBlocks(SizeType blockCount) {
+			return allocate(getAttributes().getBlockSize() * blockCount);
+		}
+
+		/// Blocks only have the alignment that their size allows, see
+		/// Attributes::getBlockAlignment.
+		Handle allocate(SizeType size) {
+			SizeType blocksRequired;
+			allocationSetup(size, blocksRequired);
+
+			auto const lock = makeAllocationLock();
+
+			SizeType index;
+			if (placement_.find(*this, blocksRequired, index))
+				return {guaranteedAllocate(index, blocksRequired), size};
 
 			return Handle::makeNullBlock();
 		}
 
-		constexpr Handle allocateAll() {
-			auto const end = Policy::getMetaDataSize();
+		Handle allocateAligned(SizeType size, SizeType alignment) {
+			SizeType blocksRequired;
+			allocationSetup(size, blocksRequired);
+
+			auto firstPtr = findNextAligned(getBlockPtr(0), alignment);
 
-			for (SizeType i {0}; i < end; ++i) {
-				Policy::getArray()[i].setAll();
+			if (firstPtr == nullptr)
+				return Handle::makeNullBlock();
+
+			auto lcm = supports::calcLcm(
+				getAttributes().getBlockSize(), alignment
+			);
+
+			// The distance between aligned blocks.
+			auto step  = getAttributes().divideByBlockSize(lcm);
+			auto first = getBlockIndex(firstPtr);
+			auto end   = getAttributes().getBlockCount();
+
+			auto const lock = makeAllocationLock();
+
+			auto hint = placement_.getHint(blocksRequired);
+			if (hint < first)
+				hint = first;
+			else
+				alignIndex(hint, first, step);
+
+			// Search from the hint to the end, then from the start to the hint.
+			SizeType index;
+			if (findAlignedRange(index, hint,  end,  step, blocksRequired) ||
+			    findAlignedRange(index, first, hint, step, blocksRequired)) {
+				return {guaranteedAllocate(index, blocksRequired), size};
 			}
 
-			return {getBlockPtr(0), Policy::getStorageSize()};
+			return Handle::makeNullBlock();
+		}
+
+		Handle allocateAll() {
+			auto const lock = makeAllocationLock();
+
+			setMetaRange(0, getBlockCount());
+
+			sizeRecovery_.reset(getBlockCount());
+			sizeRecovery_.setRunEnd(getBlockCount() - 1);
+
+			return {getBlockPtr(0), getStorageSize()};
 		}
 
 
@@ -267,22 +735,18 @@ Allocator : private t_Policy {
 
 				// The amount of blocks it takes up.
 				std::size_t blocks {
-					block.getSize() / getAttributes().getBlockSize()
+					getAttributes().divideByBlockSize(block.getSize())
 				};
 
 				std::size_t blockIndexStart {getBlockIndex(ptr)};
-				std::size_t objectEnd       {blockIndexStart + blocks};
 
-				std::size_t blockIndex {blockIndexStart};
-				while (blockIndex < objectEnd) {
-					unsetMetaBit(blockIndex);
+				auto const lock = makeAllocationLock();
 
-					++blockIndex;
-				}
+				unsetMetaRange(blockIndexStart, blocks);
+				placement_.onDeallocate(blockIndexStart, blocks);
 
-#ifdef BRH_CPP_ALLOCATORS_BITMAPPED_BLOCK_NEXT_BYTE_DEALLOCATION
-				allocateByteHint_ = getMetaIndex(getBlockIndex(ptr));
-#endif
+				if (blocks != 0)
+					releaseRunEnd(blockIndexStart, blocks);
 			}
 
 #ifdef BRH_CPP_ALLOCATORS_THROW_IN_DEALLOCATION
@@ -294,14 +758,40 @@ Allocator : private t_Policy {
 #endif
 		}
 
-		constexpr void deallocateAll() {
-			auto const end = getAttributes().getMetaDataSize();
+		/// Only with size recovery. The pointer must be the start of
+		/// a block that was allocated and not yet deallocated.
+		template <class Recovery = SizeRecovery>
+		typename std::enable_if<Recovery::enabled>::type
+		deallocate(void * ptr) {
+			if (owns({ptr, 0}))
+				deallocate(getBlock(ptr));
+		}
 
-			for (SizeType i {0}; i < end; ++i) {
-				Policy::getElements()[i].unsetAll();
-			}
+		void deallocateAll() {
+			auto const lock = makeAllocationLock();
+
+			std::memset(static_cast<void *>(getMeta()), 0, getMetaEnd());
+
+			placement_.reset();
+			sizeRecovery_.reset(getBlockCount());
+		}
+
+		/// Only with size recovery.
+		/// @return The block starting at the pointer with the size that
+		///         allocate returned for it.
+		template <class Recovery = SizeRecovery>
+		typename std::enable_if<Recovery::enabled, Handle>::type
+		getBlock(void * ptr) const {
+			auto const first = getBlockIndex(ptr);
+
+			auto const lock = makeAllocationLock();
+			auto const last = sizeRecovery_.findRunEnd(first);
+
+			return {ptr, (last - first + 1) * getAttributes().getBlockSize()};
+		}
 
-			allocateByteHint_ = 0;
+		SizeRecovery const & getSizeRecovery() const {
+			return sizeRecovery_;
 		}
 
 
@@ -350,25 +840,20 @@ Allocator : private t_Policy {
 			auto beginBlock = getBlockIndex(beginPtr);
 			auto endBlock   = getBlockIndex(endPtr);
 
-			bool fits;
-
-			if (Policy::getAttributes().getBlockCount() < endBlock)
-				fits = false;
+			auto const lock = makeAllocationLock();
 
-			else {
-				fits = true;
-				for (SizeType i {beginBlock}; i < endBlock; ++i) {
-					if (getMetaBit(i) == 1) {
-						fits = false;
-						break;
-					}
-				}
-			}
+			bool fits {
+				endBlock <= getBlockCount() &&
+				isRangeFree(beginBlock, endBlock - beginBlock)
+			};
 
 			if (fits) {
-				for (SizeType i {beginBlock}; i < endBlock; ++i) {
-					setMetaBit(i);
-				}
+				setMetaRange(beginBlock, endBlock - beginBlock);
+
+				if (beginBlock != 0)
+					sizeRecovery_.unsetRunEnd(beginBlock - 1);
+
+				sizeRecovery_.setRunEnd(endBlock - 1);
 
 				block.setSize(block.getSize() + extra);
 
@@ -382,10 +867,7 @@ Allocator : private t_Policy {
 		bool owns(Handle block) {
 			auto ptr = static_cast<Pointer>(block.getPtr());
 
-			return (
-				ptr >= Policy::getElements() + getAttributes().getMetaDataSize() &&
-				beforeEnd(ptr)
-			);
+			return (ptr >= getStorage() && beforeEnd(ptr));
 		}
 
 		bool withinBounds(Handle block) {
@@ -393,21 +875,20 @@ Allocator : private t_Policy {
 			auto ptrRight = ptrLeft + block.getSize();
 
 			return (
-				ptrLeft >= Policy::getElements() +
-				           getAttributes().getMetaDataSize() &&
-				ptrRight <= Policy::getElements() + getAttributes().getTotalSize()
+				ptrLeft  >= getStorage() &&
+				ptrRight <= getStorage() + getAttributes().getStorageSize()
 			);
 		}
 
 		bool beforeEnd(Pointer ptr) const {
-			return (ptr <  Policy::getElements() + getAttributes().getTotalSize());
+			return (ptr < getStorage() + getAttributes().getStorageSize());
 		}
 
 		bool isEmpty() const {
-			auto const end = Policy::getBlockCount();
+			auto const end = getMetaWordCount();
 
 			for (SizeType i {0}; i < end; ++i) {
-				if (getMetaBit(i) == 1)
+				if ((loadMetaWord(i) & getValidMask(i)) != 0)
 					return false;
 			}
 
@@ -415,10 +896,10 @@ Allocator : private t_Policy {
 		}
 
 		bool isFull() const {
-			auto const end = Policy::getBlockCount();
+			auto const end = getMetaWordCount();
 
 			for (SizeType i {0}; i < end; ++i) {
-				if (getMetaBit(i) == 0)
+				if ((~loadMetaWord(i) & getValidMask(i)) != 0)
 					return false;
 			}
 
@@ -426,29 +907,12 @@ Allocator : private t_Policy {
 		}
 
 		SizeType calcUnoccupied() const {
-			SizeType count {0};
-
-			auto const end = Policy::getBlockCount();
-
-			for (SizeType i {0}; i < end; ++i) {
-				if (getMetaBit(i) == 0)
-					++count;
-			}
-
-			return count * Policy::getBlockSize();
+			return (getAttributes().getBlockCount() - countUsedBlocks()) *
+			       getAttributes().getBlockSize();
 		}
 
 		SizeType calcOccupied() const {
-			SizeType count {0};
-
-			auto const end = Policy::getBlockCount();
-
-			for (SizeType i {0}; i < end; ++i) {
-				if (getMetaBit(i) == 1)
-					++count;
-			}
-
-			return count * Policy::getBlockSize();
+			return countUsedBlocks() * getAttributes().getBlockSize();
 		}
 
 		/// @return Second block.
@@ -462,27 +926,23 @@ Allocator : private t_Policy {
 				return splitBlockUnchecked(block, firstBlockSize);
 		}
 
+		/// Holds off every allocation and deallocation of other threads
+		/// until unlock, for example while the process forks.
+		void lock() const {
+			allocationLock_.lock();
+		}
 
-	private:
-#ifdef BRH_CPP_ALLOCATORS_MULTITHREADED
-		using MutexType = std::mutex;
-		using LockType  = std::lock_guard<MutexType>;
-#endif
-
-		bool alignLocation(SizeType & byte,
-		                   ByteType & bit,
-		                   SizeType   startIndex,
-		                   SizeType   step) const {
-			auto index = getBlockIndex(byte, bit);
+		void unlock() const {
+			allocationLock_.unlock();
+		}
 
-			if (!alignIndex(index, startIndex, step))
-				return false;
 
-			byte = getMetaIndex   (index);
-			bit  = getMetaBitIndex(index);
+	private:
+		using LockMember = PaddedLockType<Lock, Policy::stateAlignment>;
+		using LockType   = std::unique_lock<LockMember>;
 
-			return true;
-		}
+		/// Meta words that takeSnapshot copies per lock, 4096 blocks.
+		static constexpr SizeType snapshotChunkWords {64};
 
 		bool alignIndex(SizeType & index,
 		                SizeType   startIndex,
@@ -499,142 +959,109 @@ Allocator : private t_Policy {
 		/// Calculates values for variables common to all allocation methods.
 		void allocationSetup(SizeType & size,
 		                     SizeType & outBlocksRequired) const {
-			size = calcRequiredSize(size);
-
 			// The amount of blocks that must be reserved for the allocation.
-			outBlocksRequired = size / getAttributes().getBlockSize();
-		}
-
-		Pointer findNextAligned(Pointer start, std::size_t alignment) const {
-			auto current = start;
-
-			while (beforeEnd(current)) {
-				if (reinterpret_cast<std::uintptr_t>(current) % alignment == 0)
-					return current;
-
-				current += Policy::getAttributes().getBlockSize();
-			}
+			outBlocksRequired = getAttributes().calcBlocksRequired(
+				size == 0 ? 1 : size
+			);
 
-			return nullptr;
+			size = outBlocksRequired * getAttributes().getBlockSize();
 		}
 
-		/// @param outFinished Indicates whether the loop reached the end.
-		/// @param byte Start byte, is altered as the function loops.
-		/// @param bit  Start bit, is altered as the function loops.
-		bool findAllocationFromLocation(bool     & outFinished,
-		                                SizeType & byte,
-		                                ByteType & bit,
-		                                SizeType   blocksRequired) {
-			SizeType currentRegionSize {0};
-
-			auto endByte = getMetaEnd();
-
-			while (byte < endByte) {
-				while (bit < arrayElementSizeBits) {
-					if (getMetaBit(byte, bit) == 0) {
-						++currentRegionSize;
-
-						if (currentRegionSize == blocksRequired) {
-							outFinished = false;
-							return true;
-						}
-					}
-
-					else {
-						outFinished = false;
-						++bit;
-						return false;
-					}
-
-					++bit;
+		/// Finds the first free range of blocks that starts at an index of
+		/// begin + n * step before end.
+		bool findAlignedRange(SizeType & outIndex,
+		                      SizeType   begin,
+		                      SizeType   end,
+		                      SizeType   step,
+		                      SizeType   blocksRequired) const {
+			auto const blockCount = getAttributes().getBlockCount();
+
+			for (SizeType index {begin};
+			     index < end && index + blocksRequired <= blockCount;
+			     index += step) {
+				if (isRangeFree(index, blocksRequired)) {
+					outIndex = index;
+					return true;
 				}
-
-				bit = 0;
-				++byte;
 			}
 
-			outFinished = true;
 			return false;
 		}
 
+		bool isRangeFree(SizeType firstIndex, SizeType blocks) const {
+			auto const end = firstIndex + blocks;
 
-		Pointer guaranteedAllocate(SizeType byte,
-		                           ByteType bit,
-		                           SizeType blocksRequired) {
-			// Set all the meta bits to indicate occupation of the blocks.
-			std::size_t lastIndex  {getBlockIndex(byte, bit)};
-			std::size_t firstIndex {lastIndex - blocksRequired + 1};
-			std::size_t index      {firstIndex};
+			return (findMetaBit(firstIndex, end, true) == end);
+		}
 
-#ifdef BRH_CPP_ALLOCATORS_BITMAPPED_BLOCK_3_STAGE_ALLOCATION
+		/// @return The index of the first block at or after from and before
+		///         end whose meta bit matches used, or end if there is none.
+		SizeType findMetaBit(SizeType from, SizeType end, bool used) const {
+			if (from >= end)
+				return end;
 
-			auto startByte = getMetaIndex   (firstIndex);
-			auto startBit  = getMetaBitIndex(firstIndex);
+			auto index     = from / metaWordBits;
+			auto lastIndex = (end - 1) / metaWordBits;
 
-			auto firstBits = arrayElementSizeBits - startBit;
-			if (firstBits > blocksRequired)
-				firstBits = static_cast<unsigned int>(blocksRequired);
+			// Ignore the bits before from in the first word.
+			auto mask = ~MetaWord {0} << (from % metaWordBits);
 
-			auto remaining = blocksRequired - firstBits;
+			for (; index <= lastIndex; ++index) {
+				auto word = loadMetaWord(index);
 
-			auto bytes    = remaining / arrayElementSizeBits;
-			auto lastBits = remaining % arrayElementSizeBits;
+				if (!used)
+					word = ~word;
 
-			auto bitIndex = startBit;
-			auto bitEnd   = startBit + firstBits;
-			while (bitIndex < bitEnd) {
-				setMetaBit(startByte, bitIndex);
-				++bitIndex;
-			}
+				word &= mask & getValidMask(index);
 
-			auto byteIndex = startByte + 1;
-			auto byteEnd   = byteIndex + bytes;
-			while (byteIndex < byteEnd) {
-				Policy::getElements()[byteIndex].setAll();
+				if (word != 0) {
+					SizeType const found {
+						index * metaWordBits + __builtin_ctzll(word)
+					};
 
-				++byteIndex;
-			}
+					return (found < end ? found : end);
+				}
 
-			bitIndex = 0;
-			bitEnd   = bitIndex + lastBits;
-			while (bitIndex < bitEnd) {
-				setMetaBit(byteEnd, bitIndex);
-				++bitIndex;
+				mask = ~MetaWord {0};
 			}
 
-#ifdef BRH_CPP_ALLOCATORS_BITMAPPED_BLOCK_NEXT_BYTE_ALLOCATION
-			auto toSet = lastIndex + 1;
-			if (toSet == getAttributes().getBlockCount())
-				allocateByteHint_ = 0;
-			else
-				allocateByteHint_ = getMetaIndex(toSet);
-#endif
-
+			return end;
+		}
 
-#else
-#ifdef BRH_CPP_ALLOCATORS_MULTITHREADED
-			std::lock_guard<std::mutex> lock {allocationMutex_};
-#endif
+		Pointer findNextAligned(Pointer start, std::size_t alignment) const {
+			auto current = start;
 
-			while (index <= lastIndex) {
-				setMetaBit(index);
+			while (beforeEnd(current)) {
+				if (reinterpret_cast<std::uintptr_t>(current) % alignment == 0)
+					return current;
 
-				++index;
+				current += Policy::getAttributes().getBlockSize();
 			}
 
-#ifdef BRH_CPP_ALLOCATORS_BITMAPPED_BLOCK_NEXT_BYTE_ALLOCATION
-			auto hint = lastIndex + 1;
-			if (hint == getAttributes().getBlockCount())
-				allocateByteHint_ = 0;
-			else
-				allocateByteHint_ = getMetaIndex(hint);
-#endif
+			return nullptr;
+		}
 
-#endif
+		/// The caller must hold the allocation lock.
+		Pointer guaranteedAllocate(SizeType firstIndex,
+		                           SizeType blocksRequired) {
+			// Set all the meta bits to indicate occupation of the blocks.
+			setMetaRange(firstIndex, blocksRequired);
 
-			auto toReturn = getBlockPtr(firstIndex);
+			placement_.onAllocate(firstIndex, blocksRequired, getBlockCount());
+			sizeRecovery_.setRunEnd(firstIndex + blocksRequired - 1);
 
-			return toReturn;
+			return getBlockPtr(firstIndex);
+		}
+
+		/// The caller must hold the allocation lock. A block that is freed
+		/// after a split leaves the rest of its allocation ending right
+		/// before it.
+		void releaseRunEnd(SizeType firstIndex, SizeType blocks) {
+			sizeRecovery_.unsetRunEnd(firstIndex + blocks - 1);
+
+			if (SizeRecovery::enabled && firstIndex != 0 &&
+			    getMetaBit(firstIndex - 1))
+				sizeRecovery_.setRunEnd(firstIndex - 1);
 		}
 
 		Handle splitBlockUnchecked(Handle & block,
@@ -657,9 +1084,8 @@ Allocator : private t_Policy {
 		}
 
 		SizeType getBlockIndex(ConstPointer blockPtr) const {
-			auto normal = blockPtr - Policy::getElements() -
-			              getAttributes().getMetaDataSize();
-			return (normal / getAttributes().getBlockSize());
+			auto normal = blockPtr - getStorage();
+			return getAttributes().divideByBlockSize(normal);
 		}
 
 
@@ -678,18 +1104,68 @@ Allocator : private t_Policy {
 
 
 		ConstPointer getBlockPtr(SizeType blockIndex) const {
-			return Policy::getElements() + getBlockPtrOffset(blockIndex);
+			return getStorage() + blockIndex * getAttributes().getBlockSize();
 		}
 
 		Pointer getBlockPtr(SizeType blockIndex) {
-			return Policy::getElements() + getBlockPtrOffset(blockIndex);
+			return getStorage() + blockIndex * getAttributes().getBlockSize();
+		}
+
+
+		Pointer      getMeta()          { return Policy::getMeta(); }
+		ConstPointer getMeta()    const { return Policy::getMeta(); }
+
+		Pointer      getStorage()       { return Policy::getStorage(); }
+		ConstPointer getStorage() const { return Policy::getStorage(); }
+
+
+		constexpr SizeType getMetaWordCount() const {
+			return supports::roundUpToMultiple(getMetaEnd(), metaWordBytes) /
+			       metaWordBytes;
+		}
+
+		/// Bit i of the word is the meta bit of block (index * 64 + i).
+		/// Bytes past the end of the meta data read as 0.
+		MetaWord loadMetaWord(SizeType index) const {
+			auto const first = index * metaWordBytes;
+			auto const end   = getMetaEnd();
+
+			MetaWord word {0};
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			if (first + metaWordBytes <= end) {
+				std::memcpy(&word, getMeta() + first, metaWordBytes);
+				return word;
+			}
+#endif
+
+			for (SizeType i {0}; i < metaWordBytes && first + i < end; ++i) {
+				MetaWord byte {
+					*reinterpret_cast<ByteType const *>(
+						&getMeta()[first + i]
+					)
+				};
+
+				word |= byte << (i * CHAR_BIT);
+			}
+
+			return word;
 		}
 
-		SizeType getBlockPtrOffset(SizeType blockIndex) const {
-			return getAttributes().getMetaDataSize() +
-				blockIndex * getAttributes().getBlockSize();
+		/// The bits of the word that belong to blocks.
+		MetaWord getValidMask(SizeType index) const {
+			auto const bits =
+				getAttributes().getBlockCount() - index * metaWordBits;
+
+			if (bits >= metaWordBits)
+				return ~MetaWord {0};
+			else
+				return (MetaWord {1} << bits) - 1;
 		}
 
+		static SizeType calcLog2(SizeType value) {
+			return metaWordBits - 1 - __builtin_clzll(value);
+		}
 
 		int getMetaBit(SizeType blockIndex) const {
 			return getMetaBit(getMetaIndex   (blockIndex),
@@ -697,7 +1173,7 @@ Allocator : private t_Policy {
 		}
 
 		int getMetaBit(SizeType metaIndex, int metaBitIndex) const {
-			return Policy::getElements()[metaIndex].getBit(metaBitIndex);
+			return getMeta()[metaIndex].getBit(metaBitIndex);
 		}
 
 		constexpr SizeType getMetaEnd() const {
@@ -706,32 +1182,58 @@ Allocator : private t_Policy {
 		}
 
 
-		void setMetaBit(SizeType blockIndex) {
-			setMetaBit(getMetaIndex(blockIndex), getMetaBitIndex(blockIndex));
+		void setMetaRange(SizeType firstIndex, SizeType blocks) {
+			writeMetaRange(firstIndex, blocks, true);
 		}
 
-		void setMetaBit(SizeType metaIndex, int metaBitIndex) {
-			Policy::getElements()[metaIndex].setBit(metaBitIndex);
+		void unsetMetaRange(SizeType firstIndex, SizeType blocks) {
+			writeMetaRange(firstIndex, blocks, false);
 		}
 
+		/// Only the partial bytes at either end of the range are masked,
+		/// the bytes in between are written whole.
+		void writeMetaRange(SizeType firstIndex, SizeType blocks, bool used) {
+			if (blocks == 0)
+				return;
 
-		void unsetMetaBit(SizeType blockIndex) {
-			unsetMetaBit(getMetaIndex(blockIndex), getMetaBitIndex(blockIndex));
-		}
+			auto const elements  = getMeta();
+			auto const lastIndex = firstIndex + blocks - 1;
+			auto const firstByte = getMetaIndex(firstIndex);
+			auto const lastByte  = getMetaIndex(lastIndex);
+
+			constexpr ByteType full {std::numeric_limits<ByteType>::max()};
 
-		void unsetMetaBit(SizeType metaIndex, int metaBitIndex) {
-			Policy::getElements()[metaIndex].unsetBit(metaBitIndex);
+			auto headMask = static_cast<ByteType>(
+				full << getMetaBitIndex(firstIndex)
+			);
+
+			auto tailMask = static_cast<ByteType>(
+				full >> (arrayElementSizeBits - 1 - getMetaBitIndex(lastIndex))
+			);
+
+			auto write = [used](ArrayElement & element, ByteType mask) {
+				if (used)
+					element.setMask(mask);
+				else
+					element.unsetMask(mask);
+			};
+
+			if (firstByte == lastByte) {
+				write(elements[firstByte], headMask & tailMask);
+				return;
+			}
+
+			write(elements[firstByte], headMask);
+
+			std::memset(static_cast<void *>(elements + firstByte + 1),
+			            used ? full : 0, lastByte - firstByte - 1);
+
+			write(elements[lastByte], tailMask);
 		}
 
-#ifdef BRH_CPP_ALLOCATORS_MULTITHREADED
 		LockType makeAllocationLock() const {
-			return {allocationMutex_};
+			return LockType {allocationLock_};
 		}
-#else
-		char makeAllocationLock() const {
-				return 0;
-			}
-#endif
 
 
 		// Calculates how efficiently memory space is used.
@@ -740,16 +1242,24 @@ Allocator : private t_Policy {
 			       / (getAttributes().getMetaDataSize() * arrayElementSizeBits);
 		}
 
-		SizeType allocateByteHint_;
+		// The hint and the lock change on every allocation, policies can
+		// keep them off the cache lines of the read mostly policy state and,
+		// through the padding after the lock, off the lines of what follows.
+		alignas(Placement) alignas(Policy::stateAlignment)
+		Placement placement_;
 
-#ifdef BRH_CPP_ALLOCATORS_MULTITHREADED
-		MutexType allocationMutex_;
-#endif
+		SizeRecovery sizeRecovery_;
+
+		mutable LockMember allocationLock_;
 };
 
 
 /// Contains values regarding information about size.
 /// Satisfies LiteralType.
+/// The arena is aligned to alignment, and blocks are a multiple of the
+/// granularity, which is the alignment unless it is given. A smaller
+/// granularity packs small blocks tighter, and blocks are then only as
+/// aligned as their size allows, see @ref getBlockAlignment.
 template <std::size_t alignment>
 class Attributes {
 	public:
@@ -757,12 +1267,14 @@ class Attributes {
 
 		/// Primary constructor.
 		constexpr Attributes(SizeType minimumBlockSize,
-                         SizeType minimumBlockCount) :
+                         SizeType minimumBlockCount,
+                         SizeType granularity = alignment) :
 			blockSize_    {supports::roundUpToMultiple(minimumBlockSize,
-			                                         alignment)},
+			                                         granularity)},
 			blockCount_   {supports::roundUpToMultiple(minimumBlockCount,
 			                                         arrayElementSizeBits)},
-			metaDataSize_ {calcMetaDataSize()} {}
+			metaDataSize_ {calcMetaDataSize()},
+			blockDivisor_ {blockSize_} {}
 
 		/// Calculates the amount of bytes that the blocks require.
 		constexpr SizeType getStorageSize() const {
@@ -786,6 +1298,25 @@ class Attributes {
 		constexpr SizeType getBlockCount()   const { return blockCount_; }
 		constexpr SizeType getMetaDataSize() const { return metaDataSize_; }
 
+		/// The blocks that hold size bytes.
+		constexpr SizeType calcBlocksRequired(SizeType size) const {
+			return blockDivisor_.divideUp(size);
+		}
+
+		/// Whole blocks in bytes, the index of the block that the byte at
+		/// that offset into the storage lies in.
+		constexpr SizeType divideByBlockSize(SizeType bytes) const {
+			return blockDivisor_.divide(bytes);
+		}
+
+		/// The alignment that every block has, the largest power of two
+		/// that divides the block size, up to the arena's alignment.
+		/// Larger alignments need allocateAligned.
+		constexpr SizeType getBlockAlignment() const {
+			return ((blockSize_ & (~blockSize_ + 1)) < alignment ?
+				(blockSize_ & (~blockSize_ + 1)) : alignment);
+		}
+
 
 	private:
 		constexpr SizeType calcMetaDataSize() const {
@@ -810,6 +1341,10 @@ class Attributes {
 		SizeType blockCount_;
 		SizeType metaDataSize_;
 
+		/// Runtime policies divide by the block size on every allocation
+		/// and deallocation.
+		common::FastDivisor blockDivisor_;
+
 		static constexpr
 		std::size_t arrayElementSize_ {sizeof(ArrayElementType)};
 
@@ -824,10 +1359,11 @@ class Attributes {
 template <template <class T, SizeType size> class ArrayType, class T,
 	SizeType    minimumBlockSize,
 	SizeType    blockCount,
-	std::size_t alignment>
+	std::size_t alignment,
+	std::size_t granularity>
 class ArrayTemplateWrapper :
 	public ArrayType<T, Attributes<alignment>(
-		minimumBlockSize, blockCount
+		minimumBlockSize, blockCount, granularity
 	).getElementCount()> {
 };
 
@@ -851,7 +1387,8 @@ class RuntimePolicy :
 	public RuntimeArrayPolicyBase<CoreArray, t_alignment> {
 
 	public:
-		static constexpr std::size_t alignment {t_alignment};
+		static constexpr std::size_t alignment      {t_alignment};
+		static constexpr std::size_t stateAlignment {1};
 
 		using AttributesType       = Attributes<alignment>;
 		using AttributesReturnType = AttributesType const &;
@@ -865,10 +1402,13 @@ class RuntimePolicy :
 			swap(first.attributes_, second.attributes_);
 		}
 
+		/// @param granularity Block sizes are a multiple of it.
 		RuntimePolicy(SizeType minimumBlockSize,
-		              SizeType minimumBlockCount) :
+		              SizeType minimumBlockCount,
+		              SizeType granularity = alignment) :
 			RuntimePolicy(AttributesType(minimumBlockSize,
-			                             minimumBlockCount)) {}
+			                             minimumBlockCount,
+			                             granularity)) {}
 
 		/*SizeType calcNeededSize(SizeType desiredSize) const {
 			return BitmappedBlock::calcNeededSize(
@@ -888,6 +1428,18 @@ class RuntimePolicy :
 			);
 		}
 
+		/// The meta data comes first, followed by the blocks.
+		ArrayElement       * getMeta()          { return getElements(); }
+		ArrayElement const * getMeta()    const { return getElements(); }
+
+		ArrayElement * getStorage() {
+			return getElements() + getAttributes().getMetaDataSize();
+		}
+
+		ArrayElement const * getStorage() const {
+			return getElements() + getAttributes().getMetaDataSize();
+		}
+
 		AttributesReturnType getAttributes() const {
 			return attributes_;
 		}
@@ -909,33 +1461,38 @@ class RuntimePolicy :
 template <template <class, SizeType> class A,
 	SizeType    s,
 	SizeType    c,
-	std::size_t a>
+	std::size_t a,
+	std::size_t g>
 struct TemplatedArrayType {
 	template <class T>
-	using Array = ArrayTemplateWrapper<A, T, s, c, a>;
+	using Array = ArrayTemplateWrapper<A, T, s, c, a, g>;
 };
 
 template <template <class, SizeType> class A,
 	SizeType    s,
 	SizeType    c,
-	std::size_t a>
+	std::size_t a,
+	std::size_t g>
 using TemplatedArrayPolicyBase =
-	traits::ArrayPolicyInterface<TemplatedArrayType<A, s, c, a>::template Array, AlignedType<a> >;
+	traits::ArrayPolicyInterface<TemplatedArrayType<A, s, c, a, g>::template Array, AlignedType<a> >;
 
+/// @tparam t_granularity Block sizes are a multiple of it.
 template <template <class T, SizeType size> class CoreArray,
 	SizeType    minimumBlockSize,
 	SizeType    t_blockCount,
-	std::size_t t_alignment>
+	std::size_t t_alignment,
+	std::size_t t_granularity = t_alignment>
 class TemplatedPolicy :
 	public TemplatedArrayPolicyBase<CoreArray,    minimumBlockSize,
-	                                t_blockCount, t_alignment> {
+	                                t_blockCount, t_alignment, t_granularity> {
 	private:
 		using PolicyBase =
 			TemplatedArrayPolicyBase<CoreArray,    minimumBlockSize,
-			                         t_blockCount, t_alignment>;
+			                         t_blockCount, t_alignment, t_granularity>;
 
 	public:
-		static constexpr std::size_t alignment {t_alignment};
+		static constexpr std::size_t alignment      {t_alignment};
+		static constexpr std::size_t stateAlignment {1};
 
 		using ArrayType        = typename PolicyBase::ArrayType;
 		using ArrayReturn      = typename PolicyBase::ArrayReturn;
@@ -945,7 +1502,7 @@ class TemplatedPolicy :
 		using AttributesReturnType = AttributesType;
 
 		static constexpr AttributesReturnType getAttributes() {
-			return {minimumBlockSize, t_blockCount};
+			return {minimumBlockSize, t_blockCount, t_granularity};
 		};
 
 		ArrayElement * getElements() {
@@ -960,27 +1517,250 @@ class TemplatedPolicy :
 			);
 		}
 
+		/// The meta data comes first, followed by the blocks.
+		ArrayElement       * getMeta()          { return getElements(); }
+		ArrayElement const * getMeta()    const { return getElements(); }
+
+		ArrayElement * getStorage() {
+			return getElements() + getAttributes().getMetaDataSize();
+		}
+
+		ArrayElement const * getStorage() const {
+			return getElements() + getAttributes().getMetaDataSize();
+		}
+
 
 	private:
 		using ArrayElementType = typename PolicyBase::ArrayType::value_type;
 };
 
 
+// Partitioned policy
+/// Keeps the meta data on cache lines of its own and starts the blocks on a
+/// fresh line, so that updating the meta data doesn't invalidate lines
+/// holding blocks that other threads use. The allocator's hint and mutex
+/// are moved onto their own line too.
+/// Both regions share one array that is aligned by hand, so any container
+/// works regardless of how it aligns its elements.
+template <template <class T> class CoreArray,
+	std::size_t t_alignment>
+class PartitionedRuntimePolicy {
+	public:
+		static constexpr std::size_t alignment      {t_alignment};
+		static constexpr std::size_t stateAlignment {cacheLineSize};
+
+		using AttributesType       = Attributes<alignment>;
+		using AttributesReturnType = AttributesType const &;
+
+		friend void swap(PartitionedRuntimePolicy & first,
+		                 PartitionedRuntimePolicy & second) {
+			using std::swap;
+
+			swap(first.attributes_,    second.attributes_);
+			swap(first.array_,         second.array_);
+			swap(first.metaOffset_,    second.metaOffset_);
+			swap(first.storageOffset_, second.storageOffset_);
+		}
+
+		/// @param granularity Block sizes are a multiple of it.
+		PartitionedRuntimePolicy(SizeType minimumBlockSize,
+		                         SizeType minimumBlockCount,
+		                         SizeType granularity = alignment) :
+			PartitionedRuntimePolicy(AttributesType(minimumBlockSize,
+			                                        minimumBlockCount,
+			                                        granularity)) {}
+
+		/// The copy may be aligned differently, so the regions are copied
+		/// separately.
+		PartitionedRuntimePolicy(PartitionedRuntimePolicy const & other) :
+			PartitionedRuntimePolicy(other.attributes_) {
+			std::memcpy(static_cast<void *>(getMeta()), other.getMeta(),
+			            calcMetaSize(attributes_));
+
+			std::memcpy(static_cast<void *>(getStorage()), other.getStorage(),
+			            attributes_.getStorageSize());
+		}
+
+		PartitionedRuntimePolicy(PartitionedRuntimePolicy && other) :
+			PartitionedRuntimePolicy(other.attributes_) {
+			swap(*this, other);
+		}
+
+		ArrayElement * getMeta() {
+			return getData() + metaOffset_;
+		}
+
+		ArrayElement const * getMeta() const {
+			return getData() + metaOffset_;
+		}
+
+		ArrayElement * getStorage() {
+			return getData() + storageOffset_;
+		}
+
+		ArrayElement const * getStorage() const {
+			return getData() + storageOffset_;
+		}
+
+		AttributesReturnType getAttributes() const {
+			return attributes_;
+		}
+
+
+	private:
+		using ArrayType = traits::RuntimeSizedArray<CoreArray, ArrayElement>;
+
+		static constexpr SizeType storageAlignment {
+			alignment > cacheLineSize ? alignment : cacheLineSize
+		};
+
+		PartitionedRuntimePolicy(AttributesType attributes) :
+			attributes_ (std::move(attributes)),
+			array_      (calcArraySize(attributes_)) {
+			auto const data = reinterpret_cast<std::uintptr_t>(getData());
+
+			auto const meta = supports::roundUpToMultiple(
+				data, static_cast<std::uintptr_t>(cacheLineSize)
+			);
+
+			auto const storage = supports::roundUpToMultiple(
+				meta + calcMetaSize(attributes_),
+				static_cast<std::uintptr_t>(storageAlignment)
+			);
+
+			metaOffset_    = meta    - data;
+			storageOffset_ = storage - data;
+		}
+
+		/// Whole cache lines, the last one isn't shared with the blocks.
+		static SizeType calcMetaSize(AttributesType const & attributes) {
+			return supports::roundUpToMultiple(
+				attributes.getBlockCount() / arrayElementSizeBits, cacheLineSize
+			);
+		}
+
+		/// Leaves room to align both regions, and pads the blocks to whole
+		/// cache lines so that the last one isn't shared with other objects.
+		static SizeType calcArraySize(AttributesType const & attributes) {
+			return (cacheLineSize - 1) +
+			       calcMetaSize(attributes) +
+			       (storageAlignment - 1) +
+			       supports::roundUpToMultiple(
+			       	attributes.getStorageSize(), cacheLineSize
+			       );
+		}
+
+		ArrayElement * getData() {
+			return &array_[0];
+		}
+
+		ArrayElement const * getData() const {
+			return &array_[0];
+		}
+
+		AttributesType attributes_;
+		ArrayType      array_;
+		SizeType       metaOffset_;
+		SizeType       storageOffset_;
+};
+
+
+// View policy
+/// Manages blocks in memory owned by someone else, such as one shard of a
+/// larger arena. The meta data needs a byte for every 8 blocks.
+template <std::size_t t_alignment>
+class ViewPolicy {
+	public:
+		static constexpr std::size_t alignment      {t_alignment};
+		static constexpr std::size_t stateAlignment {1};
+
+		using AttributesType       = Attributes<alignment>;
+		using AttributesReturnType = AttributesType const &;
+
+		friend void swap(ViewPolicy & first, ViewPolicy & second) {
+			using std::swap;
+
+			swap(first.attributes_, second.attributes_);
+			swap(first.meta_,       second.meta_);
+			swap(first.storage_,    second.storage_);
+		}
+
+		ViewPolicy(AttributesType   attributes,
+		           ArrayElement   * meta,
+		           ArrayElement   * storage) :
+			attributes_ (std::move(attributes)),
+			meta_       (meta),
+			storage_    (storage) {}
+
+		static constexpr SizeType calcMetaSize(AttributesType const & attributes) {
+			return attributes.getBlockCount() / arrayElementSizeBits;
+		}
+
+		ArrayElement       * getMeta()          { return meta_; }
+		ArrayElement const * getMeta()    const { return meta_; }
+
+		ArrayElement       * getStorage()       { return storage_; }
+		ArrayElement const * getStorage() const { return storage_; }
+
+		AttributesReturnType getAttributes() const {
+			return attributes_;
+		}
+
+
+	private:
+		AttributesType   attributes_;
+		ArrayElement   * meta_;
+		ArrayElement   * storage_;
+};
+
+
 template <template <class T> class ArrayType,
-	std::size_t alignment = alignof(std::max_align_t)>
-using Runtime =
-Allocator<RuntimePolicy<ArrayType, alignment> >;
+	std::size_t alignment    = alignof(std::max_align_t),
+	class       Placement    = NextFit,
+	class       SizeRecovery = NoSizeRecovery,
+	class       Lock         = multithread::DefaultLock>
+using Runtime = Allocator<
+	RuntimePolicy<ArrayType, alignment>, Placement, SizeRecovery, Lock>;
 
 
 template <template <class T, SizeType size> class CoreArray,
 	std::size_t minimumBlockSize,
 	std::size_t blockCount,
-	std::size_t alignment = alignof(std::max_align_t)>
+	std::size_t alignment    = alignof(std::max_align_t),
+	class       Placement    = NextFit,
+	class       SizeRecovery = NoSizeRecovery,
+	class       Lock         = multithread::DefaultLock>
 using Templated =
 Allocator<TemplatedPolicy<
-					CoreArray, minimumBlockSize, blockCount, alignment>
+					CoreArray, minimumBlockSize, blockCount, alignment>,
+          Placement,
+          SizeRecovery,
+          Lock
 >;
 
+/// Blocks are a multiple of the granularity instead of the alignment, so
+/// that small blocks aren't padded to the arena's alignment.
+template <template <class T, SizeType size> class CoreArray,
+	std::size_t minimumBlockSize,
+	std::size_t blockCount,
+	std::size_t granularity,
+	std::size_t alignment    = alignof(std::max_align_t),
+	class       Placement    = NextFit,
+	class       SizeRecovery = NoSizeRecovery,
+	class       Lock         = multithread::DefaultLock>
+using Granular = Allocator<
+	TemplatedPolicy<CoreArray, minimumBlockSize, blockCount, alignment, granularity>,
+	Placement, SizeRecovery, Lock>;
+
+
+template <template <class T> class ArrayType,
+	std::size_t alignment    = alignof(std::max_align_t),
+	class       Placement    = NextFit,
+	class       SizeRecovery = NoSizeRecovery,
+	class       Lock         = multithread::DefaultLock>
+using Partitioned = Allocator<
+	PartitionedRuntimePolicy<ArrayType, alignment>, Placement, SizeRecovery, Lock>;
+
 		} // bitmapped_block
 
 
@@ -988,11 +1768,38 @@ Allocator<TemplatedPolicy<
 /// An allocator with memory segmented into blocks and meta data before the
 /// blocks telling whether each is occupied or not.
 /// This is a 1 bit per block overhead.
+/// The placement strategy decides which free blocks an allocation takes,
+/// next fit is the default. With RunEndBitmap as size recovery blocks can
+/// also be deallocated from their pointer alone. The lock guards each
+/// instance, NoLock for arenas that only one thread uses.
 class BitmappedBlock
 {
 	public:
-		template <class Policy>
-		using Allocator = bitmapped_block::Allocator<Policy>;
+		template <class Policy,
+		          class Placement    = bitmapped_block::NextFit,
+		          class SizeRecovery = bitmapped_block::NoSizeRecovery,
+		          class Lock         = multithread::DefaultLock>
+		using Allocator =
+			bitmapped_block::Allocator<Policy, Placement, SizeRecovery, Lock>;
+
+		using FirstFit = bitmapped_block::FirstFit;
+		using NextFit  = bitmapped_block::NextFit;
+
+		template <SizeType window = 8>
+		using BestFit = bitmapped_block::BestFit<window>;
+
+		template <SizeType bucketCount = 8>
+		using SegregatedHints = bitmapped_block::SegregatedHints<bucketCount>;
+
+		using FragmentationSnapshot = bitmapped_block::FragmentationSnapshot;
+
+		using NoSizeRecovery = bitmapped_block::NoSizeRecovery;
+		using RunEndBitmap   = bitmapped_block::RunEndBitmap;
+
+		using NoLock      = multithread::NoLock;
+		using MutexLock   = multithread::MutexLock;
+		using SpinLock    = multithread::SpinLock;
+		using DefaultLock = multithread::DefaultLock;
 
 		template <template <class T> class CoreArray,
 			std::size_t alignment>
@@ -1002,21 +1809,62 @@ class BitmappedBlock
 		template <template <class T, SizeType size> class CoreArray,
 			SizeType    minimumBlockSize,
 			SizeType    blockCount,
-			std::size_t alignment>
+			std::size_t alignment,
+			std::size_t granularity = alignment>
 		using TemplatedPolicy = bitmapped_block::TemplatedPolicy<
-			CoreArray, minimumBlockSize, blockCount, alignment>;
+			CoreArray, minimumBlockSize, blockCount, alignment, granularity>;
+
+		template <template <class T> class CoreArray,
+			std::size_t alignment>
+		using PartitionedRuntimePolicy =
+			bitmapped_block::PartitionedRuntimePolicy<CoreArray, alignment>;
+
+		template <std::size_t alignment>
+		using ViewPolicy = bitmapped_block::ViewPolicy<alignment>;
 
 		template <template <class T> class ArrayType,
-			std::size_t alignment = alignof(std::max_align_t)>
-		using Runtime = bitmapped_block::Runtime<ArrayType, alignment>;
+			std::size_t alignment    = alignof(std::max_align_t),
+			class       Placement    = NextFit,
+			class       SizeRecovery = NoSizeRecovery,
+			class       Lock         = DefaultLock>
+		using Runtime = bitmapped_block::Runtime<
+			ArrayType, alignment, Placement, SizeRecovery, Lock>;
 
 
 		template <template <class T, SizeType size> class CoreArray,
 			std::size_t minimumBlockSize,
 			std::size_t blockCount,
-			std::size_t alignment = alignof(std::max_align_t)>
+			std::size_t alignment    = alignof(std::max_align_t),
+			class       Placement    = NextFit,
+			class       SizeRecovery = NoSizeRecovery,
+			class       Lock         = DefaultLock>
 		using Templated = bitmapped_block::Templated<
-			CoreArray, minimumBlockSize, blockCount, alignment>;
+			CoreArray, minimumBlockSize, blockCount,
+			alignment, Placement, SizeRecovery, Lock>;
+
+		/// Blocks are a multiple of the granularity rather than the
+		/// alignment. Larger alignments are asked for per allocation.
+		template <template <class T, SizeType size> class CoreArray,
+			std::size_t minimumBlockSize,
+			std::size_t blockCount,
+			std::size_t granularity,
+			std::size_t alignment    = alignof(std::max_align_t),
+			class       Placement    = NextFit,
+			class       SizeRecovery = NoSizeRecovery,
+			class       Lock         = DefaultLock>
+		using Granular = bitmapped_block::Granular<
+			CoreArray, minimumBlockSize, blockCount, granularity,
+			alignment, Placement, SizeRecovery, Lock>;
+
+		/// Meta data and mutable state on cache lines of their own, for
+		/// arenas that several threads share.
+		template <template <class T> class ArrayType,
+			std::size_t alignment    = alignof(std::max_align_t),
+			class       Placement    = NextFit,
+			class       SizeRecovery = NoSizeRecovery,
+			class       Lock         = DefaultLock>
+		using Partitioned = bitmapped_block::Partitioned<
+			ArrayType, alignment, Placement, SizeRecovery, Lock>;
 };
 
 
@@ -0,0 +1,295 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_CASCADING_ALLOCATOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_CASCADING_ALLOCATOR_H
+
+#include <new>
+#include <utility>
+
+#include "common/common_types.h"
+#include "common/move_block.h"
+#include "blocks/block.h"
+#include "traits/traits.h"
+
+namespace brh {
+	namespace allocators {
+		namespace cascading {
+
+/// @tparam spareCount Empty children that are kept instead of released,
+///                    so that a workload hovering around the capacity of
+///                    a child doesn't create and release one every time.
+template <SizeType t_spareCount = 1>
+class TemplatedPolicy {
+	public:
+		static constexpr SizeType getSpareCount() { return t_spareCount; }
+};
+
+
+/// Grows a fixed size allocator into a heap. When every child is full,
+/// another one is constructed in memory from Parent. Allocations try the
+/// child that last succeeded first, and blocks go back to the child that
+/// owns them.
+///
+/// Every child counts its live blocks, a child whose count drops to zero
+/// is empty. Empty children beyond the policy's spare count are destroyed
+/// and their memory given back to Parent, the others are reset through
+/// deallocateAll if they have it.
+///
+/// Children are default constructed in place and never moved, so fixed
+/// arenas with inline arrays work. Not thread safe.
+template <class t_Policy, class t_Child, class t_Parent>
+class Allocator : private t_Policy,
+                  private t_Parent
+{
+	public:
+		using Policy = t_Policy;
+		using Child  = t_Child;
+		using Parent = t_Parent;
+		using Handle = RawBlock;
+
+		Allocator() {}
+
+		Allocator(Parent parent) : Parent(std::move(parent)) {}
+
+		Allocator(Allocator && other) :
+			Parent      (std::move(other.getParent())),
+			head_       {other.head_},
+			recent_     {other.recent_},
+			emptyCount_ {other.emptyCount_} {
+
+			other.head_       = nullptr;
+			other.recent_     = nullptr;
+			other.emptyCount_ = 0;
+		}
+
+		Allocator(Allocator const &) = delete;
+
+		~Allocator() {
+			deallocateAll();
+		}
+
+		Handle allocate(SizeType size) {
+			return allocateWith([size](Child & child) {
+				return child.allocate(size);
+			});
+		}
+
+		Handle allocateAligned(SizeType size, SizeType alignment) {
+			return allocateWith([size, alignment](Child & child) {
+				return traits::allocateAligned(child, size, alignment);
+			});
+		}
+
+		constexpr void deallocate(NullBlock) const {}
+
+		void deallocate(Handle block) {
+			if (block.isNull())
+				return;
+
+			auto const node = findOwner(block);
+
+			if (node == nullptr)
+				return;
+
+			node->child.deallocate(block);
+
+			if (--node->liveCount == 0) {
+				++emptyCount_;
+
+				// Children like StackAllocator only take back some blocks,
+				// a spare is reset so that all of it can be used again.
+				if (emptyCount_ > Policy::getSpareCount())
+					release(node);
+				else
+					traits::deallocateAll(node->child);
+			}
+		}
+
+		/// Resizes within the owning child, otherwise moves the block to
+		/// wherever it fits.
+		bool reallocate(Handle & block, SizeType newSize) {
+			if (block.isNull()) {
+				block = allocate(newSize);
+				return !block.isNull();
+			}
+
+			auto const node = findOwner(block);
+
+			if (node != nullptr && traits::reallocate(node->child, block, newSize))
+				return true;
+
+			return common::moveBlock(*this, *this, block, newSize);
+		}
+
+		/// Only in place within the owning child.
+		bool expand(Handle & block, SizeType amount) {
+			auto const node = findOwner(block);
+
+			if (node == nullptr)
+				return (amount == 0);
+
+			return traits::expand(node->child, block, amount);
+		}
+
+		bool owns(Handle block) {
+			return (findOwner(block) != nullptr);
+		}
+
+		/// Destroys every child.
+		void deallocateAll() {
+			while (head_ != nullptr)
+				release(head_);
+		}
+
+		bool isEmpty() const {
+			return (emptyCount_ == getChildCount());
+		}
+
+		SizeType getChildCount() const {
+			SizeType count {0};
+
+			for (auto node = head_; node != nullptr; node = node->next)
+				++count;
+
+			return count;
+		}
+
+		Parent       & getParent()       { return *this; }
+		Parent const & getParent() const { return *this; }
+
+
+	private:
+		struct Node {
+			Child    child;
+			Node   * next      {nullptr};
+			SizeType liveCount {0};
+			SizeType nodeSize  {0};
+		};
+
+		template <class Function>
+		Handle allocateWith(Function function) {
+			if (recent_ != nullptr) {
+				auto const block = function(recent_->child);
+
+				if (!block.isNull())
+					return allocated(recent_, block);
+			}
+
+			for (auto node = head_; node != nullptr; node = node->next) {
+				if (node == recent_)
+					continue;
+
+				auto const block = function(node->child);
+
+				if (!block.isNull()) {
+					recent_ = node;
+					return allocated(node, block);
+				}
+			}
+
+			auto const node = create();
+
+			if (node == nullptr)
+				return Handle::makeNullBlock();
+
+			auto const block = function(node->child);
+
+			// Too large for any child, a new one would stay empty.
+			if (block.isNull()) {
+				release(node);
+				return Handle::makeNullBlock();
+			}
+
+			recent_ = node;
+			return allocated(node, block);
+		}
+
+		Handle allocated(Node * node, Handle block) {
+			if (node->liveCount++ == 0)
+				--emptyCount_;
+
+			return block;
+		}
+
+		Node * findOwner(Handle block) {
+			if (recent_ != nullptr && recent_->child.owns(block))
+				return recent_;
+
+			for (auto node = head_; node != nullptr; node = node->next) {
+				if (node->child.owns(block))
+					return node;
+			}
+
+			return nullptr;
+		}
+
+		/// Constructs an empty child at the front.
+		Node * create() {
+			auto const block = traits::allocateAligned(
+				getParent(), sizeof(Node), alignof(Node)
+			);
+
+			if (block.isNull())
+				return nullptr;
+
+			auto const node = new (block.getPtr()) Node();
+
+			node->next     = head_;
+			node->nodeSize = block.getSize();
+			head_          = node;
+
+			++emptyCount_;
+			return node;
+		}
+
+		void release(Node * node) {
+			auto link = &head_;
+
+			while (*link != node)
+				link = &(*link)->next;
+
+			*link = node->next;
+
+			if (recent_ == node)
+				recent_ = head_;
+
+			if (node->liveCount == 0)
+				--emptyCount_;
+
+			Handle const block {node, node->nodeSize};
+
+			node->~Node();
+			getParent().deallocate(block);
+		}
+
+		Node   * head_       {nullptr};
+		Node   * recent_     {nullptr};
+		SizeType emptyCount_ {0};
+};
+
+
+template <class Child, class Parent, SizeType spareCount = 1>
+using Templated = Allocator<TemplatedPolicy<spareCount>, Child, Parent>;
+
+		} // cascading
+
+
+
+/// Chains instances of a fixed size allocator, creating another from a
+/// parent allocator whenever all of them are full.
+class CascadingAllocator {
+	public:
+		template <class Policy, class Child, class Parent>
+		using Allocator = cascading::Allocator<Policy, Child, Parent>;
+
+		template <SizeType spareCount = 1>
+		using TemplatedPolicy = cascading::TemplatedPolicy<spareCount>;
+
+		template <class Child, class Parent, SizeType spareCount = 1>
+		using Templated = cascading::Templated<Child, Parent, spareCount>;
+};
+
+
+
+	}
+}
+
+#endif
@@ -8,6 +8,9 @@ namespace brh {
 
 using SizeType = std::size_t;
 
+/// Objects written by different threads should be at least this far apart.
+static constexpr SizeType cacheLineSize {64};
+
 	}
 }
 
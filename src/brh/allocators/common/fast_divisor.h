@@ -0,0 +1,98 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COMMON_FAST_DIVISOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COMMON_FAST_DIVISOR_H
+
+#include <cstdint>
+
+#include "common_types.h"
+
+namespace brh {
+	namespace allocators {
+		namespace common {
+
+/// Divides by a value that is only known at run time but never changes,
+/// without a division instruction. A power of two becomes a shift, any
+/// other divisor a multiplication by a precomputed reciprocal followed by
+/// shifts (Granlund and Montgomery's round up method), which is exact for
+/// every dividend. Compilers do the same for divisors known at compile
+/// time, so constant attributes lose nothing.
+class FastDivisor {
+	public:
+		/// @param divisor Must be above 0 and below 2^63.
+		constexpr FastDivisor(SizeType divisor) :
+			divisor_    {divisor},
+			shift_      {calcShift(divisor)},
+			multiplier_ {calcMultiplier(divisor, calcShift(divisor))} {}
+
+		constexpr SizeType getDivisor() const { return divisor_; }
+
+		constexpr SizeType divide(SizeType dividend) const {
+			if (multiplier_ == 0)
+				return (dividend >> shift_);
+
+#ifdef __SIZEOF_INT128__
+			auto const high = static_cast<SizeType>(
+				(static_cast<Wide>(multiplier_) * dividend) >> 64
+			);
+
+			return ((high + ((dividend - high) >> 1)) >> (shift_ - 1));
+#else
+			return (dividend / divisor_);
+#endif
+		}
+
+		constexpr SizeType calcRemainder(SizeType dividend) const {
+			return (dividend - divide(dividend) * divisor_);
+		}
+
+		/// Divides and rounds up.
+		constexpr SizeType divideUp(SizeType dividend) const {
+			return divide(dividend + divisor_ - 1);
+		}
+
+
+	private:
+#ifdef __SIZEOF_INT128__
+		using Wide = unsigned __int128;
+#endif
+
+		static constexpr bool isPowerOfTwo(SizeType value) {
+			return ((value & (value - 1)) == 0);
+		}
+
+		/// The base 2 logarithm rounded up.
+		static constexpr unsigned calcShift(SizeType divisor) {
+			unsigned shift {0};
+
+			while ((SizeType {1} << shift) < divisor)
+				++shift;
+
+			return shift;
+		}
+
+		/// 0 for powers of two, which only shift.
+		static constexpr SizeType calcMultiplier(SizeType divisor,
+		                                         unsigned shift) {
+			if (isPowerOfTwo(divisor))
+				return 0;
+
+#ifdef __SIZEOF_INT128__
+			return static_cast<SizeType>(
+				(static_cast<Wide>((SizeType {1} << shift) - divisor) << 64) /
+					divisor
+			) + 1;
+#else
+			return 1;
+#endif
+		}
+
+		SizeType divisor_;
+		unsigned shift_;
+		SizeType multiplier_;
+};
+
+
+		}
+	}
+}
+
+#endif
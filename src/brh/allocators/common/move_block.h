@@ -0,0 +1,43 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COMMON_MOVE_BLOCK_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COMMON_MOVE_BLOCK_H
+
+#include <algorithm>
+#include <cstring>
+
+#include "common_types.h"
+#include "../blocks/block.h"
+
+namespace brh {
+	namespace allocators {
+		namespace common {
+
+/// Moves a block into memory allocated from newOwner and gives the old
+/// memory back to oldOwner. Used by composites once resizing in place
+/// has failed. Only the bytes that are live in both blocks are copied.
+///
+/// @return Whether newOwner could allocate, block is unchanged if not.
+template <class OldOwner, class NewOwner>
+bool moveBlock(OldOwner & oldOwner,
+               NewOwner & newOwner,
+               RawBlock & block,
+               SizeType   newSize) {
+	RawBlock newBlock {newOwner.allocate(newSize)};
+
+	if (newBlock.isNull())
+		return false;
+
+	std::memcpy(newBlock.getPtr(), block.getPtr(),
+	            std::min(block.getSize(), newSize));
+
+	oldOwner.deallocate(block);
+	block = newBlock;
+
+	return true;
+}
+
+
+		}
+	}
+}
+
+#endif
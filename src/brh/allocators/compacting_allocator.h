@@ -0,0 +1,410 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COMPACTING_ALLOCATOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COMPACTING_ALLOCATOR_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <supports/round_up_to_multiple.h>
+
+#include "common/common_types.h"
+#include "blocks/block.h"
+
+#include "stack_allocator.h"
+
+namespace brh {
+	namespace allocators {
+		namespace compacting {
+
+/// Refers to a block for as long as it lives, no matter where compaction
+/// moves it.
+class Handle {
+	public:
+		static constexpr SizeType nullIndex {
+			std::numeric_limits<SizeType>::max()
+		};
+
+		constexpr Handle() : index_ {nullIndex} {}
+		constexpr explicit Handle(SizeType index) : index_ {index} {}
+
+		constexpr bool     isNull()   const { return (index_ == nullIndex); }
+		constexpr SizeType getIndex() const { return index_; }
+
+		friend bool operator==(Handle first, Handle second) {
+			return (first.getIndex() == second.getIndex());
+		}
+
+		friend bool operator!=(Handle first, Handle second) {
+			return !(first == second);
+		}
+
+
+	private:
+		SizeType index_;
+};
+
+
+/// Limits the work of a single call to compact. The first block of a call
+/// is always moved so that every call makes progress.
+struct Budget {
+	using Duration = std::chrono::steady_clock::duration;
+
+	SizeType bytes {std::numeric_limits<SizeType>::max()};
+	Duration time  {Duration::max()};
+
+	static Budget makeUnlimited() { return {}; }
+
+	static Budget makeBytes(SizeType bytes) {
+		Budget budget;
+		budget.bytes = bytes;
+		return budget;
+	}
+
+	static Budget makeTime(Duration time) {
+		Budget budget;
+		budget.time = time;
+		return budget;
+	}
+};
+
+
+/// Allocates by bumping the top of the arena, like StackAllocator, and
+/// hands out Handles into a table instead of pointers. Deallocation leaves
+/// a hole, and compact slides the live blocks that follow the first hole
+/// down over it with memmove while updating the table.
+///
+/// Every block starts with a header holding its table entry and size, so
+/// that the arena can be walked in address order.
+///
+/// Pointers from @ref getBlock are only valid until the next call to
+/// compact or reallocate. Not thread safe.
+template <class t_Policy>
+class Allocator : private t_Policy
+{
+	public:
+		using Policy = t_Policy;
+		using Handle = compacting::Handle;
+
+		static constexpr SizeType alignment {alignof(std::max_align_t)};
+
+		Allocator() : Allocator (Policy()) {}
+
+		Allocator(Policy policy) : Policy (std::move(policy)) {
+			auto const data = reinterpret_cast<std::uintptr_t>(getData());
+
+			begin_ = static_cast<SizeType>(
+				supports::roundUpToMultiple(
+					data, static_cast<std::uintptr_t>(alignment)
+				) - data
+			);
+
+			if (begin_ > Policy::getStackSize())
+				begin_ = Policy::getStackSize();
+
+			top_ = begin_;
+			resetPass();
+		}
+
+		Allocator(Allocator const &) = delete;
+
+		static constexpr SizeType calcRequiredSize(SizeType desiredSize) {
+			return headerSize + supports::roundUpToMultiple(
+				desiredSize == 0 ? 1 : desiredSize, alignment
+			);
+		}
+
+		/// Fails if the space above the top is too small, even if compact
+		/// would free enough.
+		Handle allocate(SizeType size) {
+			if (size > getEnd() - top_)
+				return {};
+
+			auto const blockSize = calcRequiredSize(size);
+
+			if (blockSize > getEnd() - top_)
+				return {};
+
+			auto const index = acquireEntry();
+
+			writeHeader(top_, {index, blockSize});
+			entries_[index] = top_;
+
+			top_      += blockSize;
+			occupied_ += blockSize;
+
+			return Handle {index};
+		}
+
+		void deallocate(Handle handle) {
+			if (handle.isNull())
+				return;
+
+			auto const offset = entries_[handle.getIndex()];
+			auto       header = readHeader(offset);
+
+			occupied_ -= header.size;
+
+			header.entry = deadEntry;
+			writeHeader(offset, header);
+
+			// Holes at or after the scan are reached by the running pass.
+			if (offset < scan_ && offset < firstHole_)
+				firstHole_ = offset;
+
+			releaseEntry(handle.getIndex());
+		}
+
+		void deallocateAll() {
+			entries_.clear();
+			freeEntry_ = Handle::nullIndex;
+			top_       = begin_;
+			occupied_  = 0;
+			firstHole_ = noHole;
+
+			resetPass();
+		}
+
+		/// Grows or shrinks the top block in place, other blocks move to
+		/// the top. The handle stays the same either way.
+		bool reallocate(Handle handle, SizeType newSize) {
+			auto const offset    = entries_[handle.getIndex()];
+			auto       header    = readHeader(offset);
+			auto const blockSize = calcRequiredSize(newSize);
+
+			if (newSize > getStorageSize())
+				return false;
+
+			if (offset + header.size == top_) {
+				if (blockSize > getEnd() - offset)
+					return false;
+
+				occupied_   = occupied_ - header.size + blockSize;
+				top_        = offset + blockSize;
+				header.size = blockSize;
+				writeHeader(offset, header);
+
+				return true;
+			}
+
+			if (blockSize > getEnd() - top_)
+				return false;
+
+			auto const usable = (header.size < blockSize ? header.size : blockSize);
+
+			std::memcpy(getData() + top_ + headerSize,
+			            getData() + offset + headerSize,
+			            usable - headerSize);
+
+			writeHeader(top_, {handle.getIndex(), blockSize});
+
+			occupied_ += blockSize - header.size;
+
+			header.entry = deadEntry;
+			writeHeader(offset, header);
+
+			if (offset < scan_ && offset < firstHole_)
+				firstHole_ = offset;
+
+			entries_[handle.getIndex()] = top_;
+			top_ += blockSize;
+
+			return true;
+		}
+
+		/// The current location of the block, without its header.
+		RawBlock getBlock(Handle handle) {
+			auto const offset = entries_[handle.getIndex()];
+
+			return {
+				getData() + offset + headerSize,
+				readHeader(offset).size - headerSize
+			};
+		}
+
+		/// Moves live blocks down over the holes until the budget is used
+		/// up. A pass starts at the lowest hole and ends at the top, and may
+		/// take several calls. Allocations during a pass are compacted by
+		/// the same pass.
+		///
+		/// @return Whether no holes are left below the top.
+		bool compact(Budget budget = Budget::makeUnlimited()) {
+			if (scan_ == noHole) {
+				if (firstHole_ >= top_) {
+					firstHole_ = noHole;
+					return true;
+				}
+
+				scan_      = firstHole_;
+				dense_     = firstHole_;
+				firstHole_ = noHole;
+			}
+
+			auto const timed = (budget.time != Budget::Duration::max());
+			auto const start = (timed ?
+				std::chrono::steady_clock::now() :
+				std::chrono::steady_clock::time_point());
+
+			SizeType moved {0};
+
+			while (scan_ < top_) {
+				auto const header = readHeader(scan_);
+
+				if (header.entry != deadEntry) {
+					if (scan_ != dense_) {
+						if (moved != 0 && (
+						    moved + header.size > budget.bytes ||
+						    (timed &&
+						     std::chrono::steady_clock::now() - start >= budget.time)))
+							return false;
+
+						std::memmove(getData() + dense_, getData() + scan_,
+						             header.size);
+
+						entries_[header.entry] = dense_;
+						moved += header.size;
+					}
+
+					dense_ += header.size;
+				}
+
+				scan_ += header.size;
+			}
+
+			top_ = dense_;
+			resetPass();
+
+			return (firstHole_ == noHole);
+		}
+
+		bool owns(Handle handle) const {
+			return (!handle.isNull() && handle.getIndex() < entries_.size());
+		}
+
+		bool isEmpty() const {
+			return (occupied_ == 0);
+		}
+
+		constexpr SizeType getStorageSize() const {
+			return Policy::getStackSize();
+		}
+
+		/// Bytes of live blocks, including their headers.
+		SizeType calcOccupied() const {
+			return occupied_;
+		}
+
+		SizeType calcUnoccupied() const {
+			return getEnd() - begin_ - occupied_;
+		}
+
+		/// Bytes of holes below the top, which only compact can reuse.
+		SizeType calcFragmented() const {
+			return top_ - begin_ - occupied_;
+		}
+
+
+	private:
+		struct Header {
+			SizeType entry;
+			SizeType size;
+		};
+
+		static constexpr SizeType headerSize {
+			supports::roundUpToMultiple(sizeof(Header), alignment)
+		};
+
+		static constexpr SizeType deadEntry {Handle::nullIndex};
+		static constexpr SizeType noHole    {std::numeric_limits<SizeType>::max()};
+
+		char       * getData()       { return Policy::getArray().data(); }
+		char const * getData() const { return Policy::getArray().data(); }
+
+		SizeType getEnd() const { return Policy::getStackSize(); }
+
+		Header readHeader(SizeType offset) const {
+			Header header;
+			std::memcpy(&header, getData() + offset, sizeof(Header));
+
+			return header;
+		}
+
+		void writeHeader(SizeType offset, Header header) {
+			std::memcpy(getData() + offset, &header, sizeof(Header));
+		}
+
+		void resetPass() {
+			scan_  = noHole;
+			dense_ = noHole;
+		}
+
+		/// Free table entries are linked through their offsets.
+		SizeType acquireEntry() {
+			if (freeEntry_ == Handle::nullIndex) {
+				entries_.push_back(0);
+				return entries_.size() - 1;
+			}
+
+			auto const index = freeEntry_;
+			freeEntry_ = entries_[index];
+
+			return index;
+		}
+
+		void releaseEntry(SizeType index) {
+			entries_[index] = freeEntry_;
+			freeEntry_      = index;
+		}
+
+		std::vector<SizeType> entries_;
+		SizeType              freeEntry_ {Handle::nullIndex};
+
+		SizeType begin_;
+		SizeType top_;
+		SizeType occupied_  {0};
+		SizeType firstHole_ {noHole};
+
+		/// Progress of the running pass, noHole between passes. Everything
+		/// below dense_ is compacted and the next block to look at is at
+		/// scan_.
+		SizeType scan_;
+		SizeType dense_;
+};
+
+
+template <template <class> class CoreArray>
+using Runtime = Allocator<stack_allocator::RuntimePolicy<CoreArray> >;
+
+template <template <class, SizeType> class CoreArray,
+	SizeType size>
+using Templated = Allocator<stack_allocator::TemplatedPolicy<CoreArray, size> >;
+
+		} // compacting
+
+
+
+/// Hands out stable handles instead of pointers so that the blocks can be
+/// slid together to undo fragmentation, a bounded amount of work at a time.
+class CompactingAllocator {
+	public:
+		template <class Policy>
+		using Allocator = compacting::Allocator<Policy>;
+
+		using Handle = compacting::Handle;
+		using Budget = compacting::Budget;
+
+		template <template <class> class CoreArray>
+		using Runtime = compacting::Runtime<CoreArray>;
+
+		template <template <class, SizeType> class CoreArray,
+			SizeType size>
+		using Templated = compacting::Templated<CoreArray, size>;
+};
+
+
+	}
+}
+
+#endif
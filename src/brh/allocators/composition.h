@@ -0,0 +1,335 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COMPOSITION_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COMPOSITION_H
+
+#include <cstddef>
+#include <limits>
+
+#include <supports/round_up_to_multiple.h>
+
+#include "common/common_types.h"
+#include "traits/traits.h"
+
+#include "bitmapped_block.h"
+#include "full_free_list.h"
+#include "stack_allocator.h"
+#include "malloc_allocator.h"
+#include "mmap_allocator.h"
+#include "segregator.h"
+#include "fallback_allocator.h"
+#include "wrappers/allocator_wrapper.h"
+
+namespace brh {
+	namespace allocators {
+		namespace composition {
+
+static constexpr SizeType unbounded {std::numeric_limits<SizeType>::max()};
+
+
+/// What is known at compile time about the sizes an allocator serves.
+/// Allocators without a specialization are trusted and skip the checks.
+template <class Allocator>
+struct Contract {
+	static constexpr bool     known     {false};
+	static constexpr SizeType maxSize   {unbounded};
+	static constexpr SizeType alignment {1};
+
+	/// The size of the block returned for a request of the passed size.
+	static constexpr SizeType calcBlockSize(SizeType size) { return size; }
+};
+
+template <template <class T, SizeType size> class CoreArray,
+	SizeType    minimumBlockSize,
+	SizeType    blockCount,
+	std::size_t t_alignment,
+	std::size_t granularity,
+	class       Placement,
+	class       SizeRecovery,
+	class       Lock>
+struct Contract<bitmapped_block::Allocator<bitmapped_block::TemplatedPolicy<
+	CoreArray, minimumBlockSize, blockCount, t_alignment, granularity>,
+	Placement, SizeRecovery, Lock> > {
+	private:
+		using Policy = bitmapped_block::TemplatedPolicy<
+			CoreArray, minimumBlockSize, blockCount, t_alignment, granularity>;
+
+	public:
+		static constexpr bool     known     {true};
+		static constexpr SizeType maxSize   {
+			Policy::getAttributes().getStorageSize()
+		};
+		static constexpr SizeType alignment {
+			Policy::getAttributes().getBlockAlignment()
+		};
+
+		static constexpr SizeType calcBlockSize(SizeType size) {
+			return supports::roundUpToMultiple(
+				size == 0 ? 1 : size, Policy::getAttributes().getBlockSize()
+			);
+		}
+};
+
+/// The regular interface hands back exactly the requested size.
+template <template <class, SizeType> class CoreArray,
+	SizeType    minimumBlockSize,
+	SizeType    blockCount,
+	std::size_t minimumAlignment>
+struct Contract<BlockAllocatorRegularInterface<full_free_list::Allocator<
+	full_free_list::TemplatedPolicy<
+		CoreArray, minimumBlockSize, blockCount, minimumAlignment> > > > {
+	private:
+		using Policy = full_free_list::TemplatedPolicy<
+			CoreArray, minimumBlockSize, blockCount, minimumAlignment>;
+
+	public:
+		static constexpr bool     known     {true};
+		static constexpr SizeType maxSize   {Policy::getBlockSize()};
+		static constexpr SizeType alignment {Policy::alignment};
+
+		static constexpr SizeType calcBlockSize(SizeType size) { return size; }
+};
+
+template <template <class T, SizeType size> class CoreArray,
+	SizeType stackSize>
+struct Contract<stack_allocator::Allocator<
+	stack_allocator::TemplatedPolicy<CoreArray, stackSize> > > {
+	static constexpr bool     known     {true};
+	static constexpr SizeType maxSize   {stackSize};
+	static constexpr SizeType alignment {1};
+
+	static constexpr SizeType calcBlockSize(SizeType size) {
+		return stack_allocator::Allocator<
+			stack_allocator::TemplatedPolicy<CoreArray, stackSize>
+		>::calcRequiredSize(size);
+	}
+};
+
+template <>
+struct Contract<MallocAllocator> {
+	static constexpr bool     known     {true};
+	static constexpr SizeType maxSize   {unbounded};
+	static constexpr SizeType alignment {alignof(std::max_align_t)};
+
+	/// Blocks carry the usable size, which isn't known ahead of time and
+	/// may exceed the request. As the small side of a Segregate they would
+	/// be freed to the large side, so only an unbounded threshold takes it.
+	static constexpr SizeType calcBlockSize(SizeType) { return unbounded; }
+};
+
+/// Only the lower bound on the page size is known at compile time.
+template <>
+struct Contract<MmapAllocator> {
+	static constexpr bool     known     {true};
+	static constexpr SizeType maxSize   {unbounded};
+	static constexpr SizeType alignment {4096};
+
+	static constexpr SizeType calcBlockSize(SizeType size) {
+		return supports::roundUpToMultiple(size == 0 ? 1 : size, alignment);
+	}
+};
+
+template <SizeType threshold, class SmallAllocator, class LargeAllocator>
+struct Contract<segregator::Allocator<
+	segregator::TemplatedPolicy<threshold>, SmallAllocator, LargeAllocator> > {
+	private:
+		using Small = Contract<SmallAllocator>;
+		using Large = Contract<LargeAllocator>;
+
+	public:
+		static constexpr bool     known     {Small::known && Large::known};
+		static constexpr SizeType maxSize   {Large::maxSize};
+		static constexpr SizeType alignment {
+			Small::alignment < Large::alignment ?
+				Small::alignment : Large::alignment
+		};
+
+		static constexpr SizeType calcBlockSize(SizeType size) {
+			return (size <= threshold ?
+				Small::calcBlockSize(size) : Large::calcBlockSize(size));
+		}
+};
+
+/// Either child may end up serving a request.
+template <class Primary, class Fallback>
+struct Contract<FallbackAllocator<Primary, Fallback> > {
+	private:
+		using First  = Contract<Primary>;
+		using Second = Contract<Fallback>;
+
+		static constexpr SizeType calcMax(SizeType first, SizeType second) {
+			return (first < second ? second : first);
+		}
+
+	public:
+		static constexpr bool     known     {First::known && Second::known};
+		static constexpr SizeType maxSize   {
+			calcMax(First::maxSize, Second::maxSize)
+		};
+		static constexpr SizeType alignment {
+			First::alignment < Second::alignment ?
+				First::alignment : Second::alignment
+		};
+
+		static constexpr SizeType calcBlockSize(SizeType size) {
+			return (size <= First::maxSize ?
+				calcMax(First::calcBlockSize(size), Second::calcBlockSize(size)) :
+				Second::calcBlockSize(size));
+		}
+};
+
+
+/// Requirements that the whole composition must meet.
+template <SizeType t_maxSize   = unbounded,
+          SizeType t_alignment = 1,
+          bool     t_expand    = false>
+struct Requirements {
+	static constexpr SizeType maxSize   {t_maxSize};
+	static constexpr SizeType alignment {t_alignment};
+	static constexpr bool     expand    {t_expand};
+};
+
+
+/// Leaf of a composition, the allocator is used as is.
+template <class Allocator>
+struct Use {
+	template <SizeType minSize, SizeType maxSize, class Require>
+	struct Build {
+		static_assert(!Contract<Allocator>::known ||
+		              Contract<Allocator>::alignment >= Require::alignment,
+		              "Allocator does not meet the required alignment");
+
+		static_assert(!Require::expand || traits::HasExpand<Allocator>::value,
+		              "Allocator can't expand blocks");
+
+		using Type = Allocator;
+	};
+};
+
+
+enum class Reach { small, large, both };
+
+constexpr Reach calcReach(SizeType threshold,
+                          SizeType minSize,
+                          SizeType maxSize) {
+	return (maxSize <= threshold ? Reach::small :
+	        minSize >  threshold ? Reach::large :
+	                               Reach::both);
+}
+
+template <SizeType threshold, class Small, class Large,
+	SizeType minSize, SizeType maxSize, class Require,
+	Reach reach = calcReach(threshold, minSize, maxSize)>
+struct SegregateBuild {
+	using SmallType =
+		typename Small::template Build<minSize, threshold, Require>::Type;
+
+	using LargeType =
+		typename Large::template Build<threshold + 1, maxSize, Require>::Type;
+
+	using SmallContract = Contract<SmallType>;
+
+	static_assert(!SmallContract::known || SmallContract::maxSize >= threshold,
+	              "SmallAllocator can't serve every size up to the threshold");
+
+	static_assert(!SmallContract::known ||
+	              SmallContract::calcBlockSize(threshold) <= threshold,
+	              "SmallAllocator returns blocks larger than the threshold");
+
+	using Type = Segregator::Templated<SmallType, LargeType, threshold>;
+};
+
+/// Every reachable size is below the threshold, the large side is dropped.
+template <SizeType threshold, class Small, class Large,
+	SizeType minSize, SizeType maxSize, class Require>
+struct SegregateBuild<threshold, Small, Large,
+                      minSize, maxSize, Require, Reach::small> {
+	using Type =
+		typename Small::template Build<minSize, maxSize, Require>::Type;
+};
+
+/// Every reachable size is above the threshold, the small side is dropped.
+template <SizeType threshold, class Small, class Large,
+	SizeType minSize, SizeType maxSize, class Require>
+struct SegregateBuild<threshold, Small, Large,
+                      minSize, maxSize, Require, Reach::large> {
+	using Type =
+		typename Large::template Build<minSize, maxSize, Require>::Type;
+};
+
+/// Builds a @ref Segregator, sizes up to and including the threshold go
+/// to Small.
+template <SizeType threshold, class Small, class Large>
+struct Segregate {
+	template <SizeType minSize, SizeType maxSize, class Require>
+	using Build = SegregateBuild<
+		threshold, Small, Large, minSize, maxSize, Require>;
+};
+
+
+template <class PrimaryType, class FallbackType, bool reachable>
+struct FallbackBuild {
+	static_assert(traits::HasOwns<PrimaryType>::value,
+	              "The primary allocator must be able to tell "
+	              "which blocks it owns");
+
+	using Type = FallbackAllocator<PrimaryType, FallbackType>;
+};
+
+/// No reachable size fits in the primary allocator, it is dropped.
+template <class PrimaryType, class FallbackType>
+struct FallbackBuild<PrimaryType, FallbackType, false> {
+	using Type = FallbackType;
+};
+
+/// Builds a @ref FallbackAllocator. The fallback must serve every size
+/// that reaches it, the primary may fail.
+template <class Primary, class Secondary>
+struct Fallback {
+	template <SizeType minSize, SizeType maxSize, class Require>
+	struct Build {
+		using PrimaryType =
+			typename Primary::template Build<minSize, maxSize, Require>::Type;
+
+		using SecondaryType =
+			typename Secondary::template Build<minSize, maxSize, Require>::Type;
+
+		static_assert(!Contract<SecondaryType>::known ||
+		              Contract<SecondaryType>::maxSize >= maxSize,
+		              "The fallback allocator can't serve every size");
+
+		using Type = typename FallbackBuild<
+			PrimaryType, SecondaryType,
+			!Contract<PrimaryType>::known ||
+				minSize <= Contract<PrimaryType>::maxSize
+		>::Type;
+	};
+};
+
+
+template <class Descriptor, class Require>
+struct Root {
+	using Type =
+		typename Descriptor::template Build<0, Require::maxSize, Require>::Type;
+
+	static_assert(!Contract<Type>::known ||
+	              Contract<Type>::maxSize >= Require::maxSize,
+	              "The composition can't serve the maximum size");
+};
+
+		} // composition
+
+
+
+/// Builds an allocator type from a composition description, for example
+/// `Compose<Segregate<64, Use<Small>, Use<Large> > >`. Size ranges,
+/// alignment and capabilities of every child are checked at compile time,
+/// and children that no size can reach are left out of the result.
+template <class Descriptor,
+          class Require = composition::Requirements<> >
+using Compose = typename composition::Root<Descriptor, Require>::Type;
+
+
+
+	}
+}
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COROUTINE_FRAME_ALLOCATOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_COROUTINE_FRAME_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#include <supports/round_up_to_multiple.h>
+
+#include "common/common_types.h"
+#include "blocks/block.h"
+
+#include "malloc_allocator.h"
+#include "thread_caching_allocator.h"
+#include "wrappers/allocator_singleton.h"
+
+namespace brh {
+	namespace allocators {
+		namespace coroutine_frame {
+
+/// Frames of up to 2 KiB come from per-thread FullFreeLists in size
+/// classes of 64 to 2048 bytes, larger ones from a central BitmappedBlock
+/// and then malloc.
+using DefaultPolicy = thread_caching::TemplatedPolicy<
+	64, 6, 64 * 1024, 64, 256, 4 * 1024, 16 * 1024, MallocAllocator>;
+
+using Default   = thread_caching::Allocator<DefaultPolicy>;
+using Singleton = AllocatorSingleton<Default>;
+
+
+/// Where a frame goes back to, stored after the end of the frame. The size
+/// is that of the whole block, which allocators may round up.
+struct FrameOwner {
+	void     * allocator;
+	void    (* deallocate)(void * allocator, RawBlock block);
+	SizeType   blockSize;
+};
+
+template <class Allocator>
+void deallocateFrame(void * allocator, RawBlock block) {
+	static_cast<Allocator *>(allocator)->deallocate(block);
+}
+
+/// Allocates a frame with its owner behind it.
+/// @throws std::bad_alloc If the allocator fails.
+template <class Allocator>
+void * allocateFrame(Allocator & allocator, std::size_t size) {
+	auto const ownerOffset = supports::roundUpToMultiple(
+		size, alignof(FrameOwner)
+	);
+
+	auto const block = allocator.allocate(ownerOffset + sizeof(FrameOwner));
+
+	if (block.isNull())
+		throw std::bad_alloc();
+
+	FrameOwner const owner {
+		&allocator, &deallocateFrame<Allocator>, block.getSize()
+	};
+
+	std::memcpy(block.getCharPtr() + ownerOffset, &owner, sizeof(FrameOwner));
+
+	return block.getPtr();
+}
+
+/// @param size The size passed to the matching allocateFrame.
+inline void deallocateFrame(void * ptr, std::size_t size) {
+	auto const ownerOffset = supports::roundUpToMultiple(
+		size, alignof(FrameOwner)
+	);
+
+	FrameOwner owner;
+	std::memcpy(&owner, static_cast<char *>(ptr) + ownerOffset,
+	            sizeof(FrameOwner));
+
+	owner.deallocate(owner.allocator, {ptr, owner.blockSize});
+}
+
+
+/// Base for promise types that takes their coroutine frames from an
+/// allocator instead of the global operator new.
+///
+/// Coroutines whose first parameters are std::allocator_arg and an
+/// allocator take their frame from that allocator, every other coroutine
+/// from the DefaultSingleton. Frames can be freed on any thread if the
+/// allocator allows it, the default one does.
+template <class DefaultSingleton = Singleton>
+class PooledPromise {
+	public:
+		static void * operator new(std::size_t size) {
+			return allocateFrame(DefaultSingleton::get(), size);
+		}
+
+		template <class Allocator, class ... ArgTypes>
+		static void * operator new(std::size_t                size,
+		                           std::allocator_arg_t,
+		                           Allocator                & allocator,
+		                           ArgTypes const         & ...) {
+			return allocateFrame(allocator, size);
+		}
+
+		/// Member coroutines get the object first.
+		template <class Object, class Allocator, class ... ArgTypes>
+		static void * operator new(std::size_t                size,
+		                           Object const             &,
+		                           std::allocator_arg_t,
+		                           Allocator                & allocator,
+		                           ArgTypes const         & ...) {
+			return allocateFrame(allocator, size);
+		}
+
+		static void operator delete(void * ptr, std::size_t size) {
+			deallocateFrame(ptr, size);
+		}
+};
+
+		} // coroutine_frame
+
+
+
+/// Coroutine frame allocation for promise types. Derive the promise type
+/// from PooledPromise to allocate its frames from thread caches instead of
+/// the global operator new.
+class CoroutineFrameAllocator {
+	public:
+		using DefaultPolicy = coroutine_frame::DefaultPolicy;
+		using Default       = coroutine_frame::Default;
+		using Singleton     = coroutine_frame::Singleton;
+
+		template <class DefaultSingleton = Singleton>
+		using PooledPromise = coroutine_frame::PooledPromise<DefaultSingleton>;
+};
+
+
+	}
+}
+
+#endif
@@ -0,0 +1,358 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_EPOCH_ALLOCATOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_EPOCH_ALLOCATOR_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/common_types.h"
+#include "blocks/block.h"
+
+namespace brh {
+	namespace allocators {
+
+/// Defers deallocation for lock free data structures, whose nodes other
+/// threads may still read after they are unlinked. Readers pin the current
+/// epoch while they touch shared nodes, and unlinked nodes are retired
+/// instead of deallocated. Blocks retired in an epoch are given to the
+/// underlying allocator once the global epoch is two ahead, which it only
+/// becomes after every pinned thread has seen the one in between.
+///
+/// Retiring appends to a list of the calling thread. Every batchSize
+/// retirements the thread tries to advance the epoch and frees its lists
+/// that have become safe, all at once. Lists of exited threads are taken
+/// over by new threads.
+///
+/// The underlying allocator must be thread safe. Threads hold on to their
+/// record of an instance until they exit, and may do so after it is
+/// destroyed, the last of the two frees the record. No thread may be
+/// pinned or retire while the instance is destroyed.
+template <class t_Allocator, SizeType t_batchSize = 128>
+class EpochAllocator : private t_Allocator
+{
+	private:
+		struct Record;
+
+	public:
+		using Allocator = t_Allocator;
+		using Handle    = RawBlock;
+
+		/// Keeps the epoch pinned while it lives. Pins nest.
+		class Guard {
+			public:
+				Guard(Guard && other) : record_ {other.record_} {
+					other.record_ = nullptr;
+				}
+
+				Guard(Guard const &) = delete;
+
+				~Guard() {
+					if (record_ != nullptr)
+						EpochAllocator::unpin(*record_);
+				}
+
+
+			private:
+				friend class EpochAllocator;
+
+				explicit Guard(Record & record) : record_ {&record} {}
+
+				Record * record_;
+		};
+
+		/// Constructs the underlying allocator in place, which need not be
+		/// movable.
+		template <class ... ArgTypes>
+		explicit EpochAllocator(ArgTypes && ... args) :
+			Allocator {std::forward<ArgTypes>(args)...} {}
+
+		EpochAllocator(EpochAllocator const &) = delete;
+
+		~EpochAllocator() {
+			auto & entries = getThreadEntries();
+
+			for (auto & entry : entries) {
+				if (entry.owner == this) {
+					drop(entry.record);
+					entry = {};
+				}
+			}
+
+			auto record = records_.load(std::memory_order_acquire);
+
+			// Records of threads that are still running are orphaned, they
+			// free them when they exit.
+			while (record != nullptr) {
+				auto const next = record->next;
+
+				for (auto & list : record->lists)
+					release(list);
+
+				drop(record);
+				record = next;
+			}
+		}
+
+		Handle allocate(SizeType size) {
+			return Allocator::allocate(size);
+		}
+
+		constexpr void deallocate(NullBlock) const {}
+
+		/// Deallocates at once, only for blocks that no other thread can
+		/// have seen.
+		void deallocate(Handle block) {
+			Allocator::deallocate(block);
+		}
+
+		/// Pins the current epoch for the calling thread.
+		Guard pin() {
+			auto & record = getRecord();
+
+			if (record.depth++ == 0) {
+				auto epoch = epoch_.load(std::memory_order_relaxed);
+
+				// The epoch may advance before the pin is visible, pin the
+				// new one then so that the pin never lags two behind.
+				while (true) {
+					record.state.store(makePinned(epoch), std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+
+					auto const current = epoch_.load(std::memory_order_relaxed);
+
+					if (current == epoch)
+						break;
+
+					epoch = current;
+				}
+			}
+
+			return Guard {record};
+		}
+
+		/// Deallocates the block once no pinned thread can still read it.
+		/// The block must already be unreachable for threads that pin from
+		/// now on.
+		void retire(Handle block) {
+			if (block.isNull())
+				return;
+
+			auto & record = getRecord();
+
+			// Orders the unlinking of the block before the epoch is read,
+			// like pin orders the pin. A stale epoch would free the block
+			// while a thread that still reached it is pinned.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			auto const epoch = epoch_.load(std::memory_order_acquire);
+			auto & list = record.lists[epoch % listCount];
+
+			// The list holds blocks of an epoch at least three behind.
+			if (list.epoch != epoch) {
+				release(list);
+				list.epoch = epoch;
+			}
+
+			list.blocks.push_back(block);
+
+			if (++record.retired >= t_batchSize) {
+				record.retired = 0;
+
+				tryAdvance();
+				collect(record);
+			}
+		}
+
+		/// Tries to advance the epoch and frees the calling thread's lists
+		/// that are safe by now.
+		void collect() {
+			tryAdvance();
+			collect(getRecord());
+		}
+
+		std::uint64_t getEpoch() const {
+			return epoch_.load(std::memory_order_relaxed);
+		}
+
+		bool owns(Handle block) {
+			return Allocator::owns(block);
+		}
+
+
+	private:
+		static constexpr SizeType listCount {3};
+
+		struct RetiredList {
+			std::uint64_t         epoch {0};
+			std::vector<RawBlock> blocks;
+		};
+
+		/// A thread's pin and retired blocks. Never freed before the
+		/// allocator, other threads read the state while advancing.
+		struct Record {
+			/// The pinned epoch shifted left with the lowest bit set, 0 if
+			/// unpinned.
+			std::atomic<std::uint64_t> state   {0};
+
+			/// The allocator and the owning thread each hold the record, 1
+			/// means it is free to take over or, for the thread holding it,
+			/// that the allocator is gone.
+			std::atomic<unsigned>      holders {2};
+			Record                   * next    {nullptr};
+
+			// Only the owning thread uses the rest.
+			SizeType                             depth   {0};
+			SizeType                             retired {0};
+			std::array<RetiredList, listCount> lists;
+		};
+
+		/// Hands the records of a thread back when it exits.
+		struct ThreadEntry {
+			EpochAllocator * owner  {nullptr};
+			Record         * record {nullptr};
+		};
+
+		struct ThreadEntries : std::vector<ThreadEntry> {
+			~ThreadEntries() {
+				for (auto & entry : *this) {
+					if (entry.owner != nullptr) {
+						entry.record->depth = 0;
+						entry.record->state.store(0, std::memory_order_release);
+						drop(entry.record);
+					}
+				}
+			}
+		};
+
+		/// Frees the record once neither the allocator nor a thread holds
+		/// it.
+		static void drop(Record * record) {
+			if (record->holders.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				delete record;
+		}
+
+		/// The allocator of the record was destroyed, possibly another one
+		/// now lives at the same address.
+		static bool isOrphaned(Record const * record) {
+			return (record->holders.load(std::memory_order_acquire) == 1);
+		}
+
+		static std::uint64_t makePinned(std::uint64_t epoch) {
+			return (epoch << 1) | 1;
+		}
+
+		static void unpin(Record & record) {
+			if (--record.depth == 0)
+				record.state.store(0, std::memory_order_release);
+		}
+
+		static ThreadEntries & getThreadEntries() {
+			thread_local ThreadEntries entries;
+			return entries;
+		}
+
+		Record & getRecord() {
+			auto & entries = getThreadEntries();
+
+			for (auto & entry : entries) {
+				if (entry.owner == this) {
+					if (!isOrphaned(entry.record))
+						return *entry.record;
+
+					drop(entry.record);
+					entry = {};
+				}
+			}
+
+			auto const record = acquireRecord();
+
+			// Reuse the entry of a destroyed instance.
+			for (auto & entry : entries) {
+				if (entry.owner != nullptr && isOrphaned(entry.record)) {
+					drop(entry.record);
+					entry = {};
+				}
+
+				if (entry.owner == nullptr) {
+					entry = {this, record};
+					return *record;
+				}
+			}
+
+			entries.push_back({this, record});
+			return *record;
+		}
+
+		/// Takes over the record of an exited thread or adds a new one.
+		Record * acquireRecord() {
+			auto record = records_.load(std::memory_order_acquire);
+
+			for (; record != nullptr; record = record->next) {
+				unsigned holders {1};
+
+				if (record->holders.load(std::memory_order_relaxed) == 1 &&
+				    record->holders.compare_exchange_strong(
+				    	holders, 2, std::memory_order_acquire,
+				    	std::memory_order_relaxed))
+					return record;
+			}
+
+			record = new Record();
+			record->next = records_.load(std::memory_order_relaxed);
+
+			while (!records_.compare_exchange_weak(record->next, record,
+			                                       std::memory_order_release,
+			                                       std::memory_order_relaxed)) {}
+
+			return record;
+		}
+
+		/// Advances the epoch if every pinned thread has seen it.
+		void tryAdvance() {
+			auto epoch = epoch_.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			auto record = records_.load(std::memory_order_acquire);
+
+			for (; record != nullptr; record = record->next) {
+				auto const state = record->state.load(std::memory_order_relaxed);
+
+				if (state != 0 && state != makePinned(epoch))
+					return;
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			epoch_.compare_exchange_strong(epoch, epoch + 1,
+			                               std::memory_order_acq_rel,
+			                               std::memory_order_relaxed);
+		}
+
+		void collect(Record & record) {
+			auto const epoch = epoch_.load(std::memory_order_acquire);
+
+			for (auto & list : record.lists) {
+				if (list.epoch + 2 <= epoch)
+					release(list);
+			}
+		}
+
+		void release(RetiredList & list) {
+			for (auto block : list.blocks)
+				Allocator::deallocate(block);
+
+			list.blocks.clear();
+		}
+
+		std::atomic<std::uint64_t> epoch_   {0};
+		std::atomic<Record *>      records_ {nullptr};
+};
+
+
+	}
+}
+
+#endif
@@ -1,9 +1,13 @@
 #ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_FALLBACK_ALLOCATOR_H
 #define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_FALLBACK_ALLOCATOR_H
 
+#include <type_traits>
+
 #include "common/common_types.h"
+#include "common/move_block.h"
 
 #include "blocks/block.h"
+#include "traits/traits.h"
 
 namespace brh {
 	namespace allocators {
@@ -24,6 +28,17 @@ class FallbackAllocator : private Primary,
 			return toReturn;
 		}
 
+		RawBlock allocateAligned(SizeType size, SizeType alignment) {
+			RawBlock toReturn {
+				traits::allocateAligned(getPrimary(), size, alignment)
+			};
+
+			if (toReturn.isNull())
+				toReturn = traits::allocateAligned(getFallback(), size, alignment);
+
+			return toReturn;
+		}
+
 		constexpr void deallocate(NullBlock) {}
 
 		void deallocate(RawBlock block) {
@@ -34,9 +49,59 @@ class FallbackAllocator : private Primary,
 				Fallback::deallocate(block);
 		}
 
-		bool owns(RawBlock block) {
-			return (Primary::owns(block) || Fallback::owns(block));
+		/// Tries to resize in place within the owner first. A block owned by
+		/// Primary that can't be resized there moves elsewhere in Primary,
+		/// and only to Fallback once Primary is out of room.
+		bool reallocate(RawBlock & block, SizeType newSize) {
+			if (Primary::owns(block)) {
+				if (traits::reallocate(getPrimary(), block, newSize))
+					return true;
+
+				if (common::moveBlock(getPrimary(), getPrimary(),
+				                      block, newSize))
+					return true;
+
+				return common::moveBlock(getPrimary(), getFallback(),
+				                         block, newSize);
+			}
+
+			else {
+				if (traits::reallocate(getFallback(), block, newSize))
+					return true;
+
+				return common::moveBlock(getFallback(), getFallback(),
+				                         block, newSize);
+			}
+		}
+
+		bool expand(RawBlock & block, SizeType amount) {
+			if (Primary::owns(block))
+				return traits::expand(getPrimary(), block, amount);
+
+			else
+				return traits::expand(getFallback(), block, amount);
 		}
+
+		template <class Second = Fallback>
+		typename std::enable_if<traits::HasOwns<Second>::value, bool>::type
+		owns(RawBlock block) {
+			return (Primary::owns(block) || Second::owns(block));
+		}
+
+		template <class Second = Fallback>
+		typename std::enable_if<
+			traits::AllHave<traits::HasDeallocateAll, Primary, Second>::value
+		>::type
+		deallocateAll() {
+			Primary::deallocateAll();
+			Second::deallocateAll();
+		}
+
+		Primary       & getPrimary()       { return *this; }
+		Primary const & getPrimary() const { return *this; }
+
+		Fallback       & getFallback()       { return *this; }
+		Fallback const & getFallback() const { return *this; }
 };
 
 
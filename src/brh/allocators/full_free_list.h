@@ -1,6 +1,10 @@
 #ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_FULL_FREE_LIST_H
 #define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_FULL_FREE_LIST_H
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
 #include <vector>
 #include <type_traits>
 
@@ -8,8 +12,9 @@
 
 #include "common/common_types.h"
 #include "common/free_list_node.h"
+#include "blocks/block.h"
 
-#include "multithread/thread.h"
+#include "multithread/lock.h"
 
 namespace brh {
 	namespace allocators {
@@ -26,22 +31,295 @@ class Iterator
 		constexpr Iterator() {}
 		constexpr Iterator(Element * ptr) : ptr_ {ptr} {}
 
-		void advance() {
-			ptr_ = ptr_->getNextNodePtr();
+		void advance(Element * base) {
+			ptr_ = ptr_->getNextNodePtr(base);
 		}
 
 		Element & get() { return *ptr_; }
 
+		Element * getPtr() const { return ptr_; }
+
 	private:
 		Element * ptr_;
 };
 
-template <class t_Policy>
+
+/// The head of the free list, every operation holds the lock.
+///
+/// Blocks that were never allocated aren't linked. Once the list is empty
+/// they are taken in address order from a bump pointer instead, so their
+/// memory is first touched when they are handed out.
+template <class Element, class Lock>
+class Root
+{
+	public:
+		friend void swap(Root & first, Root & second) {
+			using std::swap;
+
+			swap(first.head_,  second.head_);
+			swap(first.base_,  second.base_);
+			swap(first.fresh_, second.fresh_);
+			swap(first.end_,   second.end_);
+		}
+
+		Element * pop() {
+			std::lock_guard<Lock> lock {lock_};
+
+			return take();
+		}
+
+		SizeType popBulk(void ** out, SizeType count) {
+			std::lock_guard<Lock> lock {lock_};
+
+			SizeType taken {0};
+
+			while (taken < count) {
+				auto const element = take();
+
+				if (element == nullptr)
+					break;
+
+				out[taken++] = element;
+			}
+
+			return taken;
+		}
+
+		void push(Element * element) {
+			std::lock_guard<Lock> lock {lock_};
+
+			// Overwrite the allocated block with a pointer to
+			// the current next block to allocate.
+			element->setNextNode(base_, head_.getPtr());
+
+			// The block being deallocated is now the next to be allocated.
+			head_ = {element};
+		}
+
+		void pushBulk(void * const * ptrs, SizeType count) {
+			std::lock_guard<Lock> lock {lock_};
+
+			for (SizeType i {0}; i < count; ++i) {
+				auto const element = static_cast<Element *>(ptrs[i]);
+
+				element->setNextNode(base_, head_.getPtr());
+				head_ = {element};
+			}
+		}
+
+		/// Makes every block from begin to end free, none of them linked.
+		void reset(Element * begin, Element * end) {
+			std::lock_guard<Lock> lock {lock_};
+
+			head_  = {nullptr};
+			base_  = begin;
+			fresh_ = begin;
+			end_   = end;
+		}
+
+		Element * peek() const {
+			if (head_.getPtr() != nullptr)
+				return head_.getPtr();
+
+			return (fresh_ != end_ ? fresh_ : nullptr);
+		}
+
+
+	private:
+		/// Takes the head of the list, or else the next block that was
+		/// never used.
+		Element * take() {
+			auto const element = head_.getPtr();
+
+			if (element != nullptr) {
+				head_.advance(base_);
+				return element;
+			}
+
+			if (fresh_ != end_)
+				return fresh_++;
+
+			return nullptr;
+		}
+
+		Iterator<Element>   head_;
+		Element           * base_  {nullptr};
+		Element           * fresh_ {nullptr};
+		Element           * end_   {nullptr};
+		Lock                lock_;
+};
+
+
+/// A Treiber stack. The head packs the position of the top block with a
+/// counter that changes on every update, so a compare and swap fails if
+/// the top was taken and given back in between.
+///
+/// Popping reads the link of a block that another thread may have taken
+/// in the meantime. The value is thrown away when the compare and swap
+/// fails, and the block stays in the array either way.
+///
+/// Blocks that were never allocated are taken by an atomic index once the
+/// stack is empty, like the locked root does with its bump pointer.
+template <class Element>
+class Root<Element, multithread::LockFree>
+{
+	public:
+		Root() : head_ {0}, fresh_ {0} {}
+
+		friend void swap(Root & first, Root & second) {
+			using std::swap;
+
+			auto const head = first.head_.load(std::memory_order_relaxed);
+			first.head_.store(second.head_.load(std::memory_order_relaxed),
+			                  std::memory_order_relaxed);
+			second.head_.store(head, std::memory_order_relaxed);
+
+			auto const fresh = first.fresh_.load(std::memory_order_relaxed);
+			first.fresh_.store(second.fresh_.load(std::memory_order_relaxed),
+			                   std::memory_order_relaxed);
+			second.fresh_.store(fresh, std::memory_order_relaxed);
+
+			swap(first.base_,  second.base_);
+			swap(first.count_, second.count_);
+		}
+
+		Element * pop() {
+			auto head = head_.load(std::memory_order_acquire);
+
+			while (true) {
+				auto const element = toElement(head);
+
+				if (element == nullptr)
+					return takeFresh();
+
+				auto const next = pack(element->getNextNodePtr(base_), head);
+
+				if (head_.compare_exchange_weak(head, next,
+				                                std::memory_order_acquire,
+				                                std::memory_order_acquire))
+					return element;
+			}
+		}
+
+		SizeType popBulk(void ** out, SizeType count) {
+			SizeType taken {0};
+
+			while (taken < count) {
+				auto const element = pop();
+
+				if (element == nullptr)
+					break;
+
+				out[taken++] = element;
+			}
+
+			return taken;
+		}
+
+		void push(Element * element) {
+			pushChain(element, element);
+		}
+
+		/// Links the blocks to each other first and then puts the whole
+		/// chain on top at once.
+		void pushBulk(void * const * ptrs, SizeType count) {
+			if (count == 0)
+				return;
+
+			auto const first = static_cast<Element *>(ptrs[0]);
+			auto       last  = first;
+
+			for (SizeType i {1}; i < count; ++i) {
+				auto const element = static_cast<Element *>(ptrs[i]);
+
+				last->setNextNode(base_, element);
+				last = element;
+			}
+
+			pushChain(first, last);
+		}
+
+		/// Makes every block from begin to end free, none of them linked.
+		/// Positions count from begin.
+		void reset(Element * begin, Element * end) {
+			base_  = begin;
+			count_ = static_cast<Word>(end - begin);
+
+			fresh_.store(0, std::memory_order_relaxed);
+			head_.store(pack(nullptr, head_.load(std::memory_order_relaxed)),
+			            std::memory_order_release);
+		}
+
+		Element * peek() const {
+			auto const element = toElement(head_.load(std::memory_order_relaxed));
+
+			if (element != nullptr)
+				return element;
+
+			auto const fresh = fresh_.load(std::memory_order_relaxed);
+
+			return (fresh < count_ ? base_ + fresh : nullptr);
+		}
+
+
+	private:
+		using Word = std::uint64_t;
+
+		static constexpr unsigned positionBits {32};
+		static constexpr Word     positionMask {(Word {1} << positionBits) - 1};
+
+		/// No other thread has seen a block that was never used, so the
+		/// index needs no ordering.
+		Element * takeFresh() {
+			if (fresh_.load(std::memory_order_relaxed) >= count_)
+				return nullptr;
+
+			auto const index = fresh_.fetch_add(1, std::memory_order_relaxed);
+
+			return (index < count_ ? base_ + index : nullptr);
+		}
+
+		void pushChain(Element * first, Element * last) {
+			auto head = head_.load(std::memory_order_relaxed);
+
+			do {
+				last->setNextNode(base_, toElement(head));
+			} while (!head_.compare_exchange_weak(head, pack(first, head),
+			                                      std::memory_order_release,
+			                                      std::memory_order_relaxed));
+		}
+
+		/// @return The new head with the counter of the old one advanced.
+		Word pack(Element * element, Word old) const {
+			Word const position {
+				element == nullptr ? 0 : static_cast<Word>(element - base_) + 1
+			};
+
+			return (((old >> positionBits) + 1) << positionBits) | position;
+		}
+
+		Element * toElement(Word head) const {
+			auto const position = head & positionMask;
+
+			return (position == 0 ? nullptr : base_ + (position - 1));
+		}
+
+		std::atomic<Word>   head_;
+		std::atomic<Word>   fresh_;
+		Element           * base_  {nullptr};
+		Word                count_ {0};
+};
+
+
+/// @tparam t_Lock Guards the free list. LockFree makes it a Treiber stack
+///                instead, which needs fewer than 2^32 blocks.
+template <class t_Policy, class t_Lock = multithread::DefaultLock>
 class alignas(t_Policy::alignment)
 Allocator : t_Policy
 {
 	public:
 		using Policy = t_Policy;
+		using Lock   = t_Lock;
 
 	private:
 		using ElementType = typename Policy::ElementType;
@@ -56,22 +334,10 @@ Allocator : t_Policy
 
 		constexpr Allocator() : Allocator(Policy()) {}
 
+		/// Doesn't touch the array, blocks are only written to once they
+		/// are allocated and given back.
 		Allocator(Policy policy) : Policy(std::move(policy)) {
-
-			ElementType       *       currentPtr {this->getArray().data()};
-			ElementType       *       nextPtr    {currentPtr + 1};
-			ElementType const * const end        {this->getArray().data() + this->getBlockCount()};
-
-			while (nextPtr < end) {
-				currentPtr->setNextNode(nextPtr);
-
-				currentPtr = nextPtr;
-				++nextPtr;
-			}
-
-			currentPtr->setNextNode(nullptr);
-
-			root_ = {this->getArray().data()};
+			resetAll();
 		}
 
 		Allocator(Allocator && other) : Allocator() {
@@ -94,22 +360,18 @@ Allocator : t_Policy
 		/// @return Guaranteed to be aligned with the alignment of
 		///         the @ref FullFreeList instantiation.
 		void * allocate() {
-			std::lock_guard<std::mutex> lock {mutex_};
-
-			auto nextSpot = static_cast<void*>(&root_.get());
-
-			// If root_ points to an unallocated spot,
-			// it now must point to a new spot.
-			if (nextSpot != nullptr) {
-				//root_ = root_->node.getNextPtr();
-				root_.advance();
-			}
+			return root_.pop();
+		}
 
-			return nextSpot;
+		/// Takes up to count blocks under a single lock.
+		///
+		/// @return The amount of blocks written to out.
+		SizeType allocateBulk(void ** out, SizeType count) {
+			return root_.popBulk(out, count);
 		}
 
 		void * allocateAligned(SizeType alignment) {
-			auto nextSpot = static_cast<void*>(&root_.get());
+			auto nextSpot = static_cast<void*>(root_.peek());
 
 			if (brh::supports::calcIsAligned(nextSpot, alignment))
 				return allocate();
@@ -125,16 +387,54 @@ Allocator : t_Policy
 		void deallocate(void * ptr) {
 			if (ptr == nullptr) return;
 
-			auto blockPtr = static_cast<ElementType*>(ptr);
+			root_.push(static_cast<ElementType*>(ptr));
+		}
 
-			std::lock_guard<std::mutex> lock {mutex_};
+		/// Gives back count blocks under a single lock.
+		void deallocateBulk(void * const * ptrs, SizeType count) {
+			root_.pushBulk(ptrs, count);
+		}
 
-			// Overwrite the allocated block with a pointer to
-			// the current next block to allocate.
-			blockPtr->setNextNode(&root_.get());
+		/// Frees every block at once, they are handed out in address order
+		/// again. No other thread may use the allocator meanwhile.
+		void deallocateAll() {
+			resetAll();
+		}
 
-			// The block being deallocated is now the next to be allocated.
-			root_ = {blockPtr};
+		SizeType getBlockCount() const {
+			return Policy::getBlockCount();
+		}
+
+		/// The position of the block in address order.
+		SizeType getBlockIndex(void const * ptr) const {
+			return static_cast<ElementType const *>(ptr) - this->getArray().data();
+		}
+
+		void * getBlockPtr(SizeType index) {
+			return this->getArray().data() + index;
+		}
+
+		/// Every element has the same capacity, so the size of a block
+		/// follows from the allocator alone.
+		RawBlock getBlock(void * ptr) const {
+			return {ptr, Policy::getBlockSize()};
+		}
+
+		/// Every element has the same capacity, so resizing only ever
+		/// succeeds in place and never has to move the data.
+		///
+		/// @return Whether the new size fits in the element.
+		bool reallocate(RawBlock & block, SizeType newSize) const {
+			if (newSize > Policy::getBlockSize())
+				return false;
+
+			block.setSize(newSize);
+			return true;
+		}
+
+		/// Fails if the expanded size does not fit in the element.
+		bool expand(RawBlock & block, SizeType amount) const {
+			return reallocate(block, block.getSize() + amount);
 		}
 
 		bool owns(void * ptr) {
@@ -143,13 +443,12 @@ Allocator : t_Policy
 		}
 
 	private:
-		using IteratorType = Iterator<ElementType>;
-
-		IteratorType root_;
+		void resetAll() {
+			root_.reset(this->getArray().data(),
+			            this->getArray().data() + this->getBlockCount());
+		}
 
-#ifdef BRH_CPP_ALLOCATORS_MULTITHREADED
-		std::mutex mutex_;
-#endif
+		Root<ElementType, Lock> root_;
 };
 
 // Represents a block in the allocator's memory.
@@ -175,11 +474,13 @@ union alignas(alignment) ArrayElement
 			return toReturn;
 		};
 
-		void setNextNode(ArrayElement * nextNode) {
+		/// Links are plain pointers, the first block of the array isn't
+		/// needed.
+		void setNextNode(ArrayElement *, ArrayElement * nextNode) {
 			nextNode_ = {nextNode};
 		}
 
-		ArrayElement * getNextNodePtr() {
+		ArrayElement * getNextNodePtr(ArrayElement *) {
 			return nextNode_;
 		}
 
@@ -195,6 +496,48 @@ union alignas(alignment) ArrayElement
 };
 
 
+/// The smallest index that can link blockCount blocks, the largest value
+/// marks the end of the list.
+template <SizeType blockCount>
+using IndexFor = typename std::conditional<
+	(blockCount < 0xFFFF), std::uint16_t, std::uint32_t
+>::type;
+
+/// A block linked by its index from the first block of the array instead
+/// of a pointer, so that blocks can be as small as the index.
+template <
+	SizeType    minimumBlockSize,
+	std::size_t alignment,
+	class       Index>
+union alignas(alignment) IndexElement
+{
+	public:
+		static constexpr SizeType getRequiredSize() {
+			constexpr SizeType minimum {
+				std::max<SizeType>(minimumBlockSize, sizeof(Index))
+			};
+
+			return ((minimum + alignment - 1) / alignment) * alignment;
+		};
+
+		void setNextNode(IndexElement * base, IndexElement * nextNode) {
+			nextIndex_ = (nextNode == nullptr ?
+				endIndex : static_cast<Index>(nextNode - base));
+		}
+
+		IndexElement * getNextNodePtr(IndexElement * base) {
+			return (nextIndex_ == endIndex ? nullptr : base + nextIndex_);
+		}
+
+
+	private:
+		static constexpr Index endIndex {std::numeric_limits<Index>::max()};
+
+		Index nextIndex_;
+		char  data_ [getRequiredSize()];
+};
+
+
 template <
 	SizeType    minimumBlockSize,
 	std::size_t minimumAlignment>
@@ -235,7 +578,7 @@ class RuntimePolicy {
 		ArrayReturn      getArray()       { return array_; }
 		ArrayConstReturn getArray() const { return array_; }
 
-		SizeType getBlockCount() { return array_.size(); }
+		SizeType getBlockCount() const { return array_.size(); }
 		static constexpr SizeType getBlockSize()  { return sizeof(ElementType); }
 
 	private:
@@ -244,9 +587,10 @@ class RuntimePolicy {
 
 template <template <class T> class CoreArray,
 	SizeType    minimumBlockSize,
-	std::size_t minimumAlignment = alignof(std::max_align_t)>
+	std::size_t minimumAlignment = alignof(std::max_align_t),
+	class       Lock             = multithread::DefaultLock>
 using Runtime = Allocator<RuntimePolicy<
-	CoreArray, minimumBlockSize, minimumAlignment> >;
+	CoreArray, minimumBlockSize, minimumAlignment>, Lock>;
 
 
 template <template <class T, SizeType size> class CoreArray,
@@ -285,18 +629,140 @@ class TemplatedPolicy {
 template <template <class, SizeType> class Array,
 	SizeType    minimumBlockSize,
 	SizeType    blockCount,
-	std::size_t minimumAlignment = alignof(std::max_align_t)>
+	std::size_t minimumAlignment = alignof(std::max_align_t),
+	class       Lock             = multithread::DefaultLock>
 using Templated = Allocator<TemplatedPolicy<
-		Array, minimumBlockSize, blockCount, minimumAlignment> >;
+		Array, minimumBlockSize, blockCount, minimumAlignment>, Lock>;
+
+
+/// Like TemplatedPolicy, but blocks are linked by 16 bit indices if the
+/// block count allows it and 32 bit ones otherwise. Blocks are at least
+/// as large and as aligned as the index rather than a pointer, which
+/// suits pools of tiny objects.
+///
+/// Blocks can be referred to compactly as well, by IndexType indices from
+/// getBlockIndex that getBlockPtr turns back into pointers.
+template <template <class T, SizeType size> class CoreArray,
+	SizeType    minimumBlockSize,
+	SizeType    blockCount,
+	std::size_t minimumAlignment>
+class IndexedPolicy {
+	public:
+		using IndexType = IndexFor<blockCount>;
+
+		static_assert(blockCount > 0 && blockCount < 0xFFFFFFFF,
+		              "The block count must fit in a 32 bit index");
+
+		static constexpr std::size_t alignment {
+			std::max<std::size_t>(minimumAlignment, alignof(IndexType))
+		};
+
+		using ElementType = IndexElement<minimumBlockSize, alignment, IndexType>;
+		using ArrayType   = CoreArray<ElementType, blockCount>;
+
+		static_assert(sizeof(ElementType) == ElementType::getRequiredSize(),
+		              "IndexElement's size is wrong");
+
+		using ArrayReturn      = ArrayType       &;
+		using ArrayConstReturn = ArrayType const &;
+
+		static constexpr SizeType calcRequiredSize(SizeType desiredSize) {
+			return getBlockSize();
+		}
+
+		ArrayReturn      getArray()       { return array_; }
+		ArrayConstReturn getArray() const { return array_; }
+
+		static constexpr SizeType getBlockCount() { return blockCount; }
+		static constexpr SizeType getBlockSize()  { return sizeof(ElementType); }
+
+	private:
+		ArrayType array_;
+};
+
+/// The alignment defaults to the index's, blocks of 2 or 4 bytes then
+/// take no more room than the objects in them.
+template <template <class, SizeType> class Array,
+	SizeType    minimumBlockSize,
+	SizeType    blockCount,
+	std::size_t minimumAlignment = 1,
+	class       Lock             = multithread::DefaultLock>
+using Indexed = Allocator<IndexedPolicy<
+		Array, minimumBlockSize, blockCount, minimumAlignment>, Lock>;
+
+
+/// Links blocks in memory owned by someone else, such as a slab of a
+/// larger reservation. The memory must be aligned to the policy's alignment
+/// and hold at least one block.
+template <SizeType    minimumBlockSize,
+          std::size_t minimumAlignment>
+class ViewPolicy {
+	public:
+		static constexpr std::size_t alignment {
+			getAlignment<minimumBlockSize, minimumAlignment>()
+		};
+
+		using ElementType = ArrayElement<minimumBlockSize, alignment>;
+
+		static_assert(sizeof(ElementType) == ElementType::getRequiredSize(),
+		              "ArrayElement's size is wrong");
+
+		/// Looks like the arrays that the other policies own.
+		class ArrayType {
+			public:
+				constexpr ArrayType(ElementType * data, SizeType size) :
+					data_ {data},
+					size_ {size} {}
+
+				ElementType * data() const { return data_; }
+				SizeType      size() const { return size_; }
+
+			private:
+				ElementType * data_;
+				SizeType      size_;
+		};
+
+		using ArrayReturn      = ArrayType;
+		using ArrayConstReturn = ArrayType;
+
+		ViewPolicy(void * memory, SizeType blockCount) :
+			array_ {static_cast<ElementType *>(memory), blockCount} {}
+
+		SizeType calcRequiredSize(SizeType desiredSize) const {
+			return getBlockSize();
+		}
+
+		ArrayReturn getArray() const { return array_; }
+
+		SizeType getBlockCount() const { return array_.size(); }
+		static constexpr SizeType getBlockSize()  { return sizeof(ElementType); }
+
+	private:
+		ArrayType array_;
+};
+
+template <SizeType    minimumBlockSize,
+          std::size_t minimumAlignment = alignof(std::max_align_t),
+          class       Lock             = multithread::DefaultLock>
+using View = Allocator<ViewPolicy<minimumBlockSize, minimumAlignment>, Lock>;
 
 		} // full_free_list
 
 
 
+/// Hands out blocks of a single size from a linked list of the free ones.
+/// The lock guards each instance, NoLock for lists that only one thread
+/// uses and LockFree for an atomic list.
 class FullFreeList {
 	public:
-		template <class Policy>
-		using Allocator = full_free_list::Allocator<Policy>;
+		template <class Policy, class Lock = multithread::DefaultLock>
+		using Allocator = full_free_list::Allocator<Policy, Lock>;
+
+		using NoLock      = multithread::NoLock;
+		using MutexLock   = multithread::MutexLock;
+		using SpinLock    = multithread::SpinLock;
+		using LockFree    = multithread::LockFree;
+		using DefaultLock = multithread::DefaultLock;
 
 
 		template <template <class T> class CoreArray,
@@ -307,9 +773,10 @@ class FullFreeList {
 
 		template <template <class T> class CoreArray,
 			SizeType    minimumBlockSize,
-			std::size_t minimumAlignment = alignof(std::max_align_t)>
+			std::size_t minimumAlignment = alignof(std::max_align_t),
+			class       Lock             = DefaultLock>
 		using Runtime = full_free_list::Runtime<
-			CoreArray, minimumBlockSize, minimumAlignment>;
+			CoreArray, minimumBlockSize, minimumAlignment, Lock>;
 
 
 		template <template <class T, SizeType size> class CoreArray,
@@ -322,9 +789,38 @@ class FullFreeList {
 		template <template <class, SizeType> class Array,
 			SizeType    minimumBlockSize,
 			SizeType    blockCount,
-			std::size_t minimumAlignment = alignof(std::max_align_t)>
+			std::size_t minimumAlignment = alignof(std::max_align_t),
+			class       Lock             = DefaultLock>
 		using Templated = full_free_list::Templated<
-			Array, minimumBlockSize, blockCount, minimumAlignment>;
+			Array, minimumBlockSize, blockCount, minimumAlignment, Lock>;
+
+
+		template <template <class T, SizeType size> class CoreArray,
+			SizeType    minimumBlockSize,
+			SizeType    blockCount,
+			std::size_t minimumAlignment>
+		using IndexedPolicy = full_free_list::IndexedPolicy<
+			CoreArray, minimumBlockSize, blockCount, minimumAlignment>;
+
+		template <template <class, SizeType> class Array,
+			SizeType    minimumBlockSize,
+			SizeType    blockCount,
+			std::size_t minimumAlignment = 1,
+			class       Lock             = DefaultLock>
+		using Indexed = full_free_list::Indexed<
+			Array, minimumBlockSize, blockCount, minimumAlignment, Lock>;
+
+
+		template <SizeType    minimumBlockSize,
+		          std::size_t minimumAlignment>
+		using ViewPolicy = full_free_list::ViewPolicy<
+			minimumBlockSize, minimumAlignment>;
+
+		template <SizeType    minimumBlockSize,
+		          std::size_t minimumAlignment = alignof(std::max_align_t),
+		          class       Lock             = DefaultLock>
+		using View = full_free_list::View<
+			minimumBlockSize, minimumAlignment, Lock>;
 };
 
 
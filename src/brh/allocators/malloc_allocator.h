@@ -1,8 +1,13 @@
 #ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MALLOC_ALLOCATOR_H
 #define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MALLOC_ALLOCATOR_H
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
+
+#include <malloc.h>
+
 #include "common/common_types.h"
 
 #include "blocks/block.h"
@@ -11,45 +16,96 @@ namespace brh {
 	namespace allocators {
 
 /// A simple wrapper of the malloc family of functions.
+/// Blocks report the usable size of the allocation, which can be larger
+/// than the requested size.
 class MallocAllocator
 {
 	public:
-		using Handle = void *;
+		using Handle = RawBlock;
 
 		constexpr MallocAllocator() {}
 
+		static constexpr SizeType getBlockAlignment() {
+			return alignof(std::max_align_t);
+		}
+
 		Handle allocate(SizeType size) const {
-			return std::malloc(size);
+			return makeBlock(std::malloc(size));
 		}
 
-		/// Allocates the region but deallocates it if it's unaligned.
+		/// @param alignment Must be a power of 2.
 		Handle allocateAligned(SizeType size, SizeType alignment) const {
-			auto ptr = allocate(size);
+			// malloc already guarantees the fundamental alignment.
+			if (alignment <= alignof(std::max_align_t))
+				return allocate(size);
 
-			if (reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0)
-				return ptr;
+			void * ptr;
+			if (posix_memalign(&ptr, alignment, size) != 0)
+				return Handle::makeNullBlock();
 
-			else {
-				deallocate(ptr);
-				return nullptr;
-			}
+			return makeBlock(ptr);
 		}
 
-		bool reallocate(Handle & ptr, SizeType newSize) const {
-			Handle newPtr {std::realloc(ptr, newSize)};
+		/// A moved block only keeps the fundamental alignment, use
+		/// @ref reallocateAligned for blocks from @ref allocateAligned.
+		bool reallocate(Handle & block, SizeType newSize) const {
+			if (expandWithinUsable(block, newSize))
+				return true;
+
+			Handle newBlock {makeBlock(std::realloc(block.getPtr(), newSize))};
+
+			if (newBlock.isNull())
+				return false;
 
-			if (newPtr != nullptr) {
-				ptr = newPtr;
+			block = newBlock;
+			return true;
+		}
+
+		bool reallocateAligned(Handle   & block,
+		                       SizeType   newSize,
+		                       SizeType   alignment) const {
+			if (expandWithinUsable(block, newSize))
 				return true;
-			}
 
-			else return false;
+			Handle newBlock {allocateAligned(newSize, alignment)};
+
+			if (newBlock.isNull())
+				return false;
+
+			std::memcpy(newBlock.getPtr(), block.getPtr(),
+			            std::min(block.getSize(), newSize));
+
+			deallocate(block);
+			block = newBlock;
+			return true;
+		}
+
+		/// Only succeeds if the allocation already has enough usable space.
+		bool expand(Handle & block, SizeType amount) const {
+			return expandWithinUsable(block, block.getSize() + amount);
 		}
 
 		constexpr void deallocate(NullBlock) const {}
 
-		void deallocate(Handle ptr) const {
-			std::free(ptr);
+		void deallocate(Handle block) const {
+			std::free(block.getPtr());
+		}
+
+
+	private:
+		static Handle makeBlock(void * ptr) {
+			if (ptr == nullptr)
+				return Handle::makeNullBlock();
+			else
+				return {ptr, malloc_usable_size(ptr)};
+		}
+
+		static bool expandWithinUsable(Handle & block, SizeType newSize) {
+			if (block.isNull() || newSize > malloc_usable_size(block.getPtr()))
+				return false;
+
+			block.setSize(newSize);
+			return true;
 		}
 };
 
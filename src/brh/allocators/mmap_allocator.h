@@ -0,0 +1,139 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MMAP_ALLOCATOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MMAP_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <supports/round_up_to_multiple.h>
+
+#include "common/common_types.h"
+
+#include "blocks/block.h"
+
+namespace brh {
+	namespace allocators {
+
+/// Maps every block separately from the kernel. Meant for large blocks
+/// that are resized often, resizing remaps the pages instead of copying.
+/// Block sizes are always a multiple of the page size.
+class MmapAllocator
+{
+	public:
+		using Handle = RawBlock;
+
+		constexpr MmapAllocator() {}
+
+		static SizeType getPageSize() {
+			static SizeType const pageSize {
+				static_cast<SizeType>(sysconf(_SC_PAGESIZE))
+			};
+
+			return pageSize;
+		}
+
+		static SizeType getBlockAlignment() {
+			return getPageSize();
+		}
+
+		SizeType calcRequiredSize(SizeType desiredSize) const {
+			if (desiredSize == 0)
+				return getPageSize();
+			else
+				return supports::roundUpToMultiple(desiredSize, getPageSize());
+		}
+
+		Handle allocate(SizeType size) const {
+			size = calcRequiredSize(size);
+
+			auto ptr = map(size);
+
+			if (ptr == nullptr)
+				return Handle::makeNullBlock();
+			else
+				return {ptr, size};
+		}
+
+		/// Alignments above the page size are reached by mapping extra
+		/// pages and unmapping the misaligned head and the unused tail.
+		Handle allocateAligned(SizeType size, SizeType alignment) const {
+			if (alignment <= getPageSize())
+				return allocate(size);
+
+			size = calcRequiredSize(size);
+
+			auto mappedSize = size + alignment - getPageSize();
+			auto mapped     = static_cast<char *>(map(mappedSize));
+
+			if (mapped == nullptr)
+				return Handle::makeNullBlock();
+
+			auto address = reinterpret_cast<std::uintptr_t>(mapped);
+			auto head    = supports::roundUpToMultiple(address, alignment) - address;
+			auto tail    = mappedSize - head - size;
+
+			if (head != 0)
+				munmap(mapped, head);
+
+			if (tail != 0)
+				munmap(mapped + head + size, tail);
+
+			return {mapped + head, size};
+		}
+
+		/// The kernel moves the pages if they can't grow in place, the
+		/// contents are never copied. A moved block only keeps
+		/// page alignment.
+		bool reallocate(Handle & block, SizeType newSize) const {
+			return remap(block, newSize, MREMAP_MAYMOVE);
+		}
+
+		/// Only succeeds if the pages after the block are unmapped.
+		bool expand(Handle & block, SizeType amount) const {
+			return remap(block, block.getSize() + amount, 0);
+		}
+
+		constexpr void deallocate(NullBlock) const {}
+
+		void deallocate(Handle block) const {
+			if (!block.isNull())
+				munmap(block.getPtr(), block.getSize());
+		}
+
+
+	private:
+		static void * map(SizeType size) {
+			auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+			if (ptr == MAP_FAILED)
+				return nullptr;
+			else
+				return ptr;
+		}
+
+		bool remap(Handle & block, SizeType newSize, int flags) const {
+			newSize = calcRequiredSize(newSize);
+
+			if (newSize == block.getSize())
+				return true;
+
+			auto ptr = mremap(block.getPtr(), block.getSize(), newSize, flags);
+
+			if (ptr == MAP_FAILED)
+				return false;
+
+			block = {ptr, newSize};
+			return true;
+		}
+};
+
+
+
+	}
+}
+
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MULTITHREAD_LOCK_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MULTITHREAD_LOCK_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "../common/common_types.h"
+
+namespace brh {
+	namespace allocators {
+		namespace multithread {
+
+// Lock policies guard the state of one allocator instance. They satisfy
+// Lockable, so std::lock_guard and std::unique_lock work with them.
+
+/// For allocators that only one thread uses, every call compiles away.
+class NoLock {
+	public:
+		void lock()     {}
+		bool try_lock() { return true; }
+		void unlock()   {}
+};
+
+
+class MutexLock {
+	public:
+		void lock()     { mutex_.lock(); }
+		bool try_lock() { return mutex_.try_lock(); }
+		void unlock()   { mutex_.unlock(); }
+
+	private:
+		std::mutex mutex_;
+};
+
+
+/// Test and test and set. Waiters spin on a plain load and back off
+/// exponentially between attempts, then yield once the backoff is at its
+/// longest. For locks that are only held for a few instructions.
+class SpinLock {
+	public:
+		void lock() {
+			SizeType backoff {1};
+
+			while (locked_.exchange(true, std::memory_order_acquire)) {
+				while (locked_.load(std::memory_order_relaxed)) {
+					if (backoff < maxBackoff) {
+						for (SizeType i {0}; i < backoff; ++i)
+							pause();
+
+						backoff *= 2;
+					}
+					else {
+						std::this_thread::yield();
+					}
+				}
+			}
+		}
+
+		bool try_lock() {
+			return (!locked_.load(std::memory_order_relaxed) &&
+			        !locked_.exchange(true, std::memory_order_acquire));
+		}
+
+		void unlock() {
+			locked_.store(false, std::memory_order_release);
+		}
+
+
+	private:
+		static constexpr SizeType maxBackoff {1024};
+
+		static void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+#elif defined(__aarch64__)
+			asm volatile ("yield");
+#endif
+		}
+
+		std::atomic<bool> locked_ {false};
+};
+
+
+/// Asks for the allocator's lock free implementation instead of a lock.
+/// Only allocators that have one accept it.
+struct LockFree {};
+
+
+/// Thread safe unless the build defines BRH_CPP_ALLOCATORS_SINGLETHREADED.
+#ifdef BRH_CPP_ALLOCATORS_SINGLETHREADED
+using DefaultLock = NoLock;
+#else
+using DefaultLock = MutexLock;
+#endif
+
+		} // multithread
+	}
+}
+
+#endif
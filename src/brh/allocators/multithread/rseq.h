@@ -0,0 +1,195 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MULTITHREAD_RSEQ_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MULTITHREAD_RSEQ_H
+
+#include "../common/common_types.h"
+
+// Restartable sequences need the registration that glibc 2.35 and later
+// make for every thread, and critical sections written for the
+// architecture. Only x86-64 has them here.
+#if defined(__linux__) && defined(__x86_64__) && defined(__has_include)
+	#if __has_include(<sys/rseq.h>)
+		#include <sys/rseq.h>
+
+		#ifdef RSEQ_SIG
+			#define BRH_CPP_ALLOCATORS_RSEQ
+		#endif
+	#endif
+#endif
+
+namespace brh {
+	namespace allocators {
+		namespace multithread {
+			namespace rseq {
+
+/// The outcome of a critical section.
+enum class Result {
+	done,
+
+	/// The magazine was empty or full.
+	failed,
+
+	/// The thread was preempted, migrated or got a signal before the
+	/// commit. Nothing was changed, try again with the CPU read anew.
+	aborted
+};
+
+#ifdef BRH_CPP_ALLOCATORS_RSEQ
+
+static_assert(RSEQ_SIG == 0x53053053,
+              "The abort signature below must match the registered one");
+
+/// Whether glibc registered rseq for the threads of the process.
+inline bool isAvailable() {
+	return (__rseq_size > 0);
+}
+
+/// The CPU that the kernel last put the thread on.
+///
+/// @return Negative if the thread has no rseq area.
+inline int getCpu() {
+	int cpu;
+
+	__asm__ __volatile__ (
+		"movl %%fs:4(%[offset]), %[cpu]\n\t"
+		: [cpu] "=r" (cpu)
+		: [offset] "r" (__rseq_offset)
+	);
+
+	return cpu;
+}
+
+// Each critical section is described by a struct rseq_cs in the __rseq_cs
+// section: version and flags, then the start, the length up to the commit
+// and the abort handler. The handler sits in __rseq_failure behind the
+// signature, which the kernel checks before jumping to it.
+
+/// Takes the top item of the magazine of the CPU if the thread still runs
+/// on it. The store to the count commits.
+inline Result pop(int cpu, SizeType * count, void ** items, void ** out) {
+	__asm__ __volatile__ goto (
+		".pushsection __rseq_cs, \"aw\"\n\t"
+		".balign 32\n\t"
+		"3:\n\t"
+		".long 0, 0\n\t"
+		".quad 1f, (2f - 1f), 4f\n\t"
+		".popsection\n\t"
+		".pushsection __rseq_cs_ptr_array, \"aw\"\n\t"
+		".quad 3b\n\t"
+		".popsection\n\t"
+
+		"leaq 3b(%%rip), %%rax\n\t"
+		"movq %%rax, %%fs:8(%[offset])\n\t"
+		"1:\n\t"
+		"cmpl %[cpu], %%fs:4(%[offset])\n\t"
+		"jnz 4f\n\t"
+		"movq %[count], %%rbx\n\t"
+		"testq %%rbx, %%rbx\n\t"
+		"jz %l[failed]\n\t"
+		"subq $1, %%rbx\n\t"
+		"movq (%[items], %%rbx, 8), %%rax\n\t"
+		"movq %%rax, %[out]\n\t"
+		"movq %%rbx, %[count]\n\t"
+		"2:\n\t"
+
+		".pushsection __rseq_failure, \"ax\"\n\t"
+		".byte 0x0f, 0xb9, 0x3d\n\t"
+		".long 0x53053053\n\t"
+		"4:\n\t"
+		"jmp %l[aborted]\n\t"
+		".popsection\n\t"
+		:
+		: [cpu]    "r" (cpu),
+		  [offset] "r" (__rseq_offset),
+		  [count]  "m" (*count),
+		  [items]  "r" (items),
+		  [out]    "m" (*out)
+		: "memory", "cc", "rax", "rbx"
+		: failed, aborted
+	);
+
+	return Result::done;
+
+	failed:
+		return Result::failed;
+
+	aborted:
+		return Result::aborted;
+}
+
+/// Puts the item on top of the magazine of the CPU if the thread still
+/// runs on it. The store to the count commits, an item written above the
+/// count before an abort is never read.
+inline Result push(int cpu, SizeType * count, void ** items,
+                   SizeType capacity, void * item) {
+	__asm__ __volatile__ goto (
+		".pushsection __rseq_cs, \"aw\"\n\t"
+		".balign 32\n\t"
+		"3:\n\t"
+		".long 0, 0\n\t"
+		".quad 1f, (2f - 1f), 4f\n\t"
+		".popsection\n\t"
+		".pushsection __rseq_cs_ptr_array, \"aw\"\n\t"
+		".quad 3b\n\t"
+		".popsection\n\t"
+
+		"leaq 3b(%%rip), %%rax\n\t"
+		"movq %%rax, %%fs:8(%[offset])\n\t"
+		"1:\n\t"
+		"cmpl %[cpu], %%fs:4(%[offset])\n\t"
+		"jnz 4f\n\t"
+		"movq %[count], %%rbx\n\t"
+		"cmpq %[capacity], %%rbx\n\t"
+		"jae %l[failed]\n\t"
+		"movq %[item], (%[items], %%rbx, 8)\n\t"
+		"addq $1, %%rbx\n\t"
+		"movq %%rbx, %[count]\n\t"
+		"2:\n\t"
+
+		".pushsection __rseq_failure, \"ax\"\n\t"
+		".byte 0x0f, 0xb9, 0x3d\n\t"
+		".long 0x53053053\n\t"
+		"4:\n\t"
+		"jmp %l[aborted]\n\t"
+		".popsection\n\t"
+		:
+		: [cpu]      "r" (cpu),
+		  [offset]   "r" (__rseq_offset),
+		  [count]    "m" (*count),
+		  [items]    "r" (items),
+		  [capacity] "r" (capacity),
+		  [item]     "r" (item)
+		: "memory", "cc", "rax", "rbx"
+		: failed, aborted
+	);
+
+	return Result::done;
+
+	failed:
+		return Result::failed;
+
+	aborted:
+		return Result::aborted;
+}
+
+#else
+
+inline bool isAvailable() { return false; }
+
+inline int getCpu() { return -1; }
+
+inline Result pop(int, SizeType *, void **, void **) {
+	return Result::failed;
+}
+
+inline Result push(int, SizeType *, void **, SizeType, void *) {
+	return Result::failed;
+}
+
+#endif
+
+			} // rseq
+		} // multithread
+	}
+}
+
+#endif
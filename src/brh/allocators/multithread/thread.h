@@ -1,11 +0,0 @@
-#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MULTITHREAD_THREAD_H
-#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MULTITHREAD_THREAD_H
-
-#define BRH_CPP_ALLOCATORS_MULTITHREADED
-
-#ifdef BRH_CPP_ALLOCATORS_MULTITHREADED
-	#include <thread>
-	#include <mutex>
-#endif
-
-#endif
@@ -0,0 +1,146 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MULTITHREAD_THREAD_LINKS_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_MULTITHREAD_THREAD_LINKS_H
+
+#include <atomic>
+#include <mutex>
+#include <new>
+
+namespace brh {
+	namespace allocators {
+		namespace multithread {
+
+template <class t_Entry>
+class ThreadLinks;
+
+
+/// Base of a thread local entry that belongs to at most one instance at
+/// a time, through that instance's ThreadLinks.
+template <class t_Entry>
+class ThreadLink {
+	public:
+		using Entry = t_Entry;
+		using Links = ThreadLinks<Entry>;
+
+		/// Only the thread that the entry belongs to may ask without the
+		/// lock. An entry of a destroyed instance is never linked to it,
+		/// even if another instance now lives at the same address.
+		bool isLinkedTo(Links const & links) const {
+			return (links_.load(std::memory_order_relaxed) == &links);
+		}
+
+
+	private:
+		friend class ThreadLinks<Entry>;
+
+		std::atomic<Links *> links_ {nullptr};
+		ThreadLink         * next_  {nullptr};
+};
+
+
+/// The thread local entries of every thread that uses an instance, for
+/// instances that threads may outlive. The destructor of the instance
+/// unlinks all entries, and an exiting thread only calls into the
+/// instance if its entry is still linked, so neither ever touches what
+/// the other has freed.
+///
+/// One lock per entry type guards all links. It outlives every instance
+/// and is only taken when a thread first uses an instance, when it exits
+/// and when an instance is destroyed.
+template <class t_Entry>
+class ThreadLinks {
+	public:
+		using Entry = t_Entry;
+		using Link  = ThreadLink<Entry>;
+
+		ThreadLinks() {}
+
+		ThreadLinks(ThreadLinks const &) = delete;
+
+		/// Links the entry unless it belongs to another instance.
+		/// @return Whether the entry is linked to this now.
+		bool link(Entry & entry) {
+			Link & link = entry;
+			std::lock_guard<std::mutex> lock {getMutex()};
+
+			if (link.links_.load(std::memory_order_relaxed) == nullptr) {
+				link.next_ = head_;
+				link.links_.store(this, std::memory_order_relaxed);
+				head_ = &link;
+			}
+
+			return link.isLinkedTo(*this);
+		}
+
+		/// Unlinks every entry, for the destructor of the instance.
+		/// @param function Called with each entry before it is unlinked.
+		template <class Function>
+		void unlinkAll(Function function) {
+			std::lock_guard<std::mutex> lock {getMutex()};
+
+			while (head_ != nullptr) {
+				auto const link = head_;
+				head_ = link->next_;
+
+				function(static_cast<Entry &>(*link));
+
+				link->next_ = nullptr;
+				link->links_.store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		/// Unlinks the entry if it is still linked, for the exit of its
+		/// thread. Safe after the instance is destroyed.
+		/// @param function Called with the entry before it is unlinked, only
+		///                 if it was linked. The instance lives until then.
+		template <class Function>
+		static void unlink(Entry & entry, Function function) {
+			Link & link = entry;
+			std::lock_guard<std::mutex> lock {getMutex()};
+
+			auto const links = link.links_.load(std::memory_order_relaxed);
+
+			if (links == nullptr)
+				return;
+
+			function(entry);
+
+			auto next = &links->head_;
+
+			while (*next != &link)
+				next = &(*next)->next_;
+
+			*next = link.next_;
+
+			link.next_ = nullptr;
+			link.links_.store(nullptr, std::memory_order_relaxed);
+		}
+
+		/// Holds off linking and unlinking of every instance until unlock,
+		/// for example while the process forks.
+		static void lock() {
+			getMutex().lock();
+		}
+
+		static void unlock() {
+			getMutex().unlock();
+		}
+
+
+	private:
+		/// Never destroyed, threads may exit after static destructors ran.
+		static std::mutex & getMutex() {
+			alignas(std::mutex) static char storage[sizeof(std::mutex)];
+			static auto const mutex = new (storage) std::mutex();
+
+			return *mutex;
+		}
+
+		Link * head_ {nullptr};
+};
+
+
+		} // multithread
+	}
+}
+
+#endif
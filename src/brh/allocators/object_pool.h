@@ -0,0 +1,293 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_OBJECT_POOL_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_OBJECT_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common/common_types.h"
+
+#include "full_free_list.h"
+#include "multithread/lock.h"
+
+namespace brh {
+	namespace allocators {
+		namespace object_pool {
+
+/// Objects of type T in the blocks of a FullFreeList whose blocks are
+/// sized and aligned for T.
+///
+/// Objects that are recycled instead of destroyed stay constructed and are
+/// handed out again by @ref acquire, for types that are cheaper to reset
+/// than to construct.
+///
+/// Not thread safe, the Runtime and Templated pools don't lock their free
+/// lists either.
+///
+/// @tparam destroyAll Whether deallocateAll destroys the objects that are
+///                    still alive. Never done for trivially destructible
+///                    types, which then need no bookkeeping of live
+///                    objects either.
+template <class T, class t_FreeList, bool t_destroyAll = true>
+class Allocator : private t_FreeList
+{
+	public:
+		using FreeList = t_FreeList;
+		using Type     = T;
+
+		static constexpr bool tracksLive {
+			t_destroyAll && !std::is_trivially_destructible<T>::value
+		};
+
+		static_assert(FreeList::Policy::getBlockSize() >= sizeof(T),
+		              "The blocks are too small for the type");
+
+		static_assert(FreeList::Policy::alignment % alignof(T) == 0,
+		              "The blocks are not aligned for the type");
+
+		Allocator() : Allocator (typename FreeList::Policy()) {}
+
+		Allocator(typename FreeList::Policy policy) :
+			FreeList (std::move(policy)) {
+			if (tracksLive)
+				live_.assign(FreeList::getBlockCount(), false);
+		}
+
+		Allocator(Allocator const &) = delete;
+
+		~Allocator() {
+			deallocateAll();
+		}
+
+		/// The block goes back to the pool if the constructor throws.
+		///
+		/// @return nullptr if the pool is exhausted.
+		template <class ... ArgTypes>
+		T * construct(ArgTypes && ... args) {
+			auto const ptr = FreeList::allocate();
+
+			if (ptr == nullptr)
+				return nullptr;
+
+			try {
+				return constructAt(ptr, std::forward<ArgTypes>(args)...);
+			}
+			catch (...) {
+				FreeList::deallocate(ptr);
+				throw;
+			}
+		}
+
+		void destroy(T * object) {
+			if (object == nullptr)
+				return;
+
+			destroyAt(object);
+			FreeList::deallocate(object);
+		}
+
+		/// Constructs up to count objects from the same arguments, taking
+		/// their blocks from the free list a batch at a time. If a
+		/// constructor throws, the objects constructed so far are destroyed
+		/// and every block goes back to the pool.
+		///
+		/// @return The amount of objects written to out.
+		template <class ... ArgTypes>
+		SizeType constructBulk(T ** out, SizeType count, ArgTypes const & ... args) {
+			void *   blocks [batchSize];
+			SizeType done   {0};
+
+			while (done < count) {
+				auto const wanted = calcBatch(count - done);
+				auto const taken  = FreeList::allocateBulk(blocks, wanted);
+
+				SizeType i {0};
+
+				try {
+					for (; i < taken; ++i)
+						out[done + i] = constructAt(blocks[i], args...);
+				}
+				catch (...) {
+					FreeList::deallocateBulk(blocks + i, taken - i);
+					destroyBulk(out, done + i);
+					throw;
+				}
+
+				done += taken;
+
+				if (taken < wanted)
+					break;
+			}
+
+			return done;
+		}
+
+		/// Destroys the objects and gives their blocks back a batch at
+		/// a time.
+		void destroyBulk(T * const * objects, SizeType count) {
+			void * blocks [batchSize];
+
+			for (SizeType done {0}; done < count; ) {
+				auto const batch = calcBatch(count - done);
+
+				for (SizeType i {0}; i < batch; ++i) {
+					destroyAt(objects[done + i]);
+					blocks[i] = objects[done + i];
+				}
+
+				FreeList::deallocateBulk(blocks, batch);
+				done += batch;
+			}
+		}
+
+		/// Keeps the object constructed for the next @ref acquire.
+		void recycle(T * object) {
+			if (object != nullptr)
+				recycled_.push_back(object);
+		}
+
+		/// Hands out a recycled object as it was left, or constructs a new
+		/// one from the arguments if there is none.
+		///
+		/// @return nullptr if the pool is exhausted.
+		template <class ... ArgTypes>
+		T * acquire(ArgTypes && ... args) {
+			if (recycled_.empty())
+				return construct(std::forward<ArgTypes>(args)...);
+
+			auto const object = recycled_.back();
+			recycled_.pop_back();
+
+			return object;
+		}
+
+		/// Destroys the recycled objects and frees their blocks.
+		void clearRecycled() {
+			destroyBulk(recycled_.data(), recycled_.size());
+			recycled_.clear();
+		}
+
+		/// Frees every block, destroying the objects that are still alive
+		/// unless destructors are skipped.
+		void deallocateAll() {
+			if (tracksLive) {
+				auto const blocks = FreeList::getBlockCount();
+				auto const first  = static_cast<T *>(getFirst());
+
+				for (SizeType i {0}; i < blocks; ++i) {
+					if (live_[i]) {
+						blockAt(first, i)->~T();
+						live_[i] = false;
+					}
+				}
+			}
+
+			recycled_.clear();
+			FreeList::deallocateAll();
+		}
+
+		bool owns(T const * object) {
+			return FreeList::owns(const_cast<T *>(object));
+		}
+
+		SizeType getCapacity() const {
+			return FreeList::getBlockCount();
+		}
+
+		SizeType getRecycledCount() const {
+			return recycled_.size();
+		}
+
+
+	private:
+		static constexpr SizeType batchSize {64};
+
+		static constexpr SizeType calcBatch(SizeType remaining) {
+			return (remaining < batchSize ? remaining : batchSize);
+		}
+
+		template <class ... ArgTypes>
+		T * constructAt(void * block, ArgTypes && ... args) {
+			auto const object = new (block) T (std::forward<ArgTypes>(args)...);
+
+			if (tracksLive)
+				live_[FreeList::getBlockIndex(block)] = true;
+
+			return object;
+		}
+
+		void destroyAt(T * object) {
+			object->~T();
+
+			if (tracksLive)
+				live_[FreeList::getBlockIndex(object)] = false;
+		}
+
+		void * getFirst() {
+			return FreeList::getBlockPtr(0);
+		}
+
+		static T * blockAt(T * first, SizeType index) {
+			return reinterpret_cast<T *>(
+				reinterpret_cast<char *>(first) +
+				index * FreeList::Policy::getBlockSize()
+			);
+		}
+
+		std::vector<bool> live_;
+		std::vector<T *>  recycled_;
+};
+
+
+/// CoreArray must allocate with the alignment of T, which std::vector
+/// only does from C++17 on.
+template <class T,
+	template <class> class CoreArray,
+	bool destroyAll = true>
+using Runtime = Allocator<
+	T,
+	full_free_list::Runtime<
+		CoreArray, sizeof(T), alignof(T), multithread::NoLock>,
+	destroyAll>;
+
+template <class T,
+	template <class, SizeType> class CoreArray,
+	SizeType blockCount,
+	bool     destroyAll = true>
+using Templated = Allocator<
+	T,
+	full_free_list::Templated<
+		CoreArray, sizeof(T), blockCount, alignof(T), multithread::NoLock>,
+	destroyAll>;
+
+		} // object_pool
+
+
+
+/// A typed pool of objects on top of FullFreeList, with bulk construction
+/// and destruction and recycling of constructed objects.
+class ObjectPool {
+	public:
+		template <class T, class FreeList, bool destroyAll = true>
+		using Allocator = object_pool::Allocator<T, FreeList, destroyAll>;
+
+		template <class T,
+			template <class> class CoreArray,
+			bool destroyAll = true>
+		using Runtime = object_pool::Runtime<T, CoreArray, destroyAll>;
+
+		template <class T,
+			template <class, SizeType> class CoreArray,
+			SizeType blockCount,
+			bool     destroyAll = true>
+		using Templated = object_pool::Templated<
+			T, CoreArray, blockCount, destroyAll>;
+};
+
+
+	}
+}
+
+#endif
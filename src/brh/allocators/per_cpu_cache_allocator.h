@@ -0,0 +1,330 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_PER_CPU_CACHE_ALLOCATOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_PER_CPU_CACHE_ALLOCATOR_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "common/common_types.h"
+#include "common/move_block.h"
+#include "blocks/block.h"
+
+#include "multithread/rseq.h"
+#include "multithread/thread_links.h"
+
+namespace brh {
+	namespace allocators {
+		namespace per_cpu_cache {
+
+/// @tparam blockSize     Sizes up to this are cached, and every cached
+///                       block is allocated from the backing allocator
+///                       with this size.
+/// @tparam cacheCapacity The most blocks that a cache holds.
+/// @tparam batchSize     Blocks taken from the backing allocator at once
+///                       when a cache runs empty.
+template <SizeType t_blockSize,
+          SizeType t_cacheCapacity = 64,
+          SizeType t_batchSize     = 16>
+class TemplatedPolicy {
+	public:
+		static constexpr SizeType getBlockSize()     { return t_blockSize; }
+		static constexpr SizeType getCacheCapacity() { return t_cacheCapacity; }
+		static constexpr SizeType getBatchSize()     { return t_batchSize; }
+
+		static_assert(t_batchSize > 0 && t_batchSize <= t_cacheCapacity,
+		              "A batch must fit in a cache");
+};
+
+
+/// A stack of free blocks.
+template <SizeType capacity>
+struct Magazine {
+	SizeType count {0};
+	void *   items [capacity];
+};
+
+
+/// Caches blocks of one size in front of a thread safe backing allocator,
+/// such as a locked FullFreeList behind BlockAllocatorRegularInterface or
+/// a locked BitmappedBlock.
+///
+/// With rseq every CPU has a cache, and pops and pushes are restartable
+/// sequences that the kernel aborts if the thread is preempted or
+/// migrated before the commit, so they need no lock or atomic. The memory
+/// held in caches is bounded by the CPU count rather than the thread count.
+/// Without rseq every thread gets a cache instead, like
+/// ThreadCachingAllocator, and threads that hold the cache of another
+/// instance go to the backing allocator.
+///
+/// Blocks don't belong to a cache, any thread can free any block. Threads
+/// may outlive an instance, its destructor gives back the blocks of every
+/// thread cache, but they must not use it after it is destroyed.
+template <class t_Policy, class t_Backing>
+class Allocator : private t_Backing {
+	public:
+		using Policy  = t_Policy;
+		using Backing = t_Backing;
+		using Handle  = RawBlock;
+
+		Allocator() : Allocator(Backing()) {}
+
+		Allocator(Backing backing) :
+			Backing (std::move(backing)),
+			cpuCaches_ (multithread::rseq::isAvailable() ? getCpuCount() : 0) {}
+
+		Allocator(Allocator const &) = delete;
+
+		~Allocator() {
+			threadCaches_.unlinkAll([this](ThreadCache & cache) {
+				release(cache.magazine);
+			});
+
+			for (auto & padded : cpuCaches_)
+				release(padded.magazine);
+		}
+
+		/// Whether the caches are per CPU, otherwise they are per thread.
+		bool hasCpuCaches() const {
+			return !cpuCaches_.empty();
+		}
+
+		Handle allocate(SizeType size) {
+			if (size > Policy::getBlockSize())
+				return getBacking().allocate(size);
+
+			auto ptr = popCached();
+
+			if (ptr == nullptr)
+				ptr = refill();
+
+			if (ptr == nullptr)
+				return Handle::makeNullBlock();
+
+			return {ptr, size};
+		}
+
+		constexpr void deallocate(NullBlock) const {}
+
+		void deallocate(Handle block) {
+			if (block.isNull())
+				return;
+
+			if (block.getSize() > Policy::getBlockSize())
+				getBacking().deallocate(block);
+
+			else if (!pushCached(block.getPtr()))
+				getBacking().deallocate({block.getPtr(), Policy::getBlockSize()});
+		}
+
+		/// Cached blocks resize in place up to the block size, other blocks
+		/// move.
+		bool reallocate(Handle & block, SizeType newSize) {
+			if (block.isNull()) {
+				block = allocate(newSize);
+				return !block.isNull();
+			}
+
+			if (block.getSize() <= Policy::getBlockSize() &&
+			    newSize         <= Policy::getBlockSize()) {
+				block.setSize(newSize);
+				return true;
+			}
+
+			return common::moveBlock(*this, *this, block, newSize);
+		}
+
+		bool owns(Handle block) {
+			return getBacking().owns(block);
+		}
+
+
+	private:
+		using Cache = Magazine<Policy::getCacheCapacity()>;
+
+		/// Keeps the caches of neighbouring CPUs on different cache lines no
+		/// matter how the vector aligns them.
+		struct PaddedCache {
+			char  padding[cacheLineSize];
+			Cache magazine;
+		};
+
+		/// Gives the blocks back when the thread exits, if the instance still
+		/// lives. The owner is only valid while linked.
+		struct ThreadCache : multithread::ThreadLink<ThreadCache> {
+			~ThreadCache() {
+				using Links = multithread::ThreadLinks<ThreadCache>;
+
+				Links::unlink(*this, [](ThreadCache & cache) {
+					cache.owner->release(cache.magazine);
+				});
+			}
+
+			Allocator * owner {nullptr};
+			Cache       magazine;
+		};
+
+		static SizeType getCpuCount() {
+			auto const count = sysconf(_SC_NPROCESSORS_CONF);
+
+			return (count < 1 ? 1 : static_cast<SizeType>(count));
+		}
+
+		static ThreadCache & getThreadCache() {
+			thread_local ThreadCache cache;
+			return cache;
+		}
+
+		/// @return nullptr if the thread holds the cache of another instance.
+		ThreadCache * acquireThreadCache() {
+			auto & cache = getThreadCache();
+
+			if (cache.isLinkedTo(threadCaches_))
+				return &cache;
+
+			if (!threadCaches_.link(cache))
+				return nullptr;
+
+			cache.owner = this;
+			return &cache;
+		}
+
+		void release(Cache & magazine) {
+			for (SizeType i {0}; i < magazine.count; ++i)
+				getBacking().deallocate({magazine.items[i], Policy::getBlockSize()});
+
+			magazine.count = 0;
+		}
+
+		/// @return nullptr if the cache is empty or the thread has none.
+		void * popCached() {
+			if (hasCpuCaches()) {
+				while (true) {
+					auto const cpu = multithread::rseq::getCpu();
+
+					if (cpu < 0 || static_cast<SizeType>(cpu) >= cpuCaches_.size())
+						return nullptr;
+
+					auto & magazine = cpuCaches_[cpu].magazine;
+					void * ptr {nullptr};
+
+					auto const result = multithread::rseq::pop(
+						cpu, &magazine.count, magazine.items, &ptr
+					);
+
+					if (result == multithread::rseq::Result::done)
+						return ptr;
+
+					if (result == multithread::rseq::Result::failed)
+						return nullptr;
+				}
+			}
+
+			auto const cache = acquireThreadCache();
+
+			if (cache == nullptr || cache->magazine.count == 0)
+				return nullptr;
+
+			return cache->magazine.items[--cache->magazine.count];
+		}
+
+		/// @return Whether the cache took the block.
+		bool pushCached(void * ptr) {
+			if (hasCpuCaches()) {
+				while (true) {
+					auto const cpu = multithread::rseq::getCpu();
+
+					if (cpu < 0 || static_cast<SizeType>(cpu) >= cpuCaches_.size())
+						return false;
+
+					auto & magazine = cpuCaches_[cpu].magazine;
+
+					auto const result = multithread::rseq::push(
+						cpu, &magazine.count, magazine.items,
+						Policy::getCacheCapacity(), ptr
+					);
+
+					if (result != multithread::rseq::Result::aborted)
+						return (result == multithread::rseq::Result::done);
+				}
+			}
+
+			auto const cache = acquireThreadCache();
+
+			if (cache == nullptr ||
+			    cache->magazine.count == Policy::getCacheCapacity())
+				return false;
+
+			cache->magazine.items[cache->magazine.count++] = ptr;
+			return true;
+		}
+
+		/// Allocates a batch from the backing allocator and caches all but
+		/// the first block, which is returned.
+		void * refill() {
+			auto const first = getBacking().allocate(Policy::getBlockSize());
+
+			if (first.isNull())
+				return nullptr;
+
+			for (SizeType i {1}; i < Policy::getBatchSize(); ++i) {
+				auto const block = getBacking().allocate(Policy::getBlockSize());
+
+				if (block.isNull())
+					break;
+
+				if (!pushCached(block.getPtr())) {
+					getBacking().deallocate(block);
+					break;
+				}
+			}
+
+			return first.getPtr();
+		}
+
+		Backing & getBacking() { return *this; }
+
+		std::vector<PaddedCache> cpuCaches_;
+
+		multithread::ThreadLinks<ThreadCache> threadCaches_;
+};
+
+
+template <class Backing,
+	SizeType blockSize,
+	SizeType cacheCapacity = 64,
+	SizeType batchSize     = 16>
+using Templated = Allocator<
+	TemplatedPolicy<blockSize, cacheCapacity, batchSize>, Backing>;
+
+		} // per_cpu_cache
+
+
+
+/// Caches blocks of one size per CPU in front of another allocator, using
+/// restartable sequences on Linux and per-thread caches elsewhere.
+class PerCpuCacheAllocator {
+	public:
+		template <class Policy, class Backing>
+		using Allocator = per_cpu_cache::Allocator<Policy, Backing>;
+
+		template <SizeType blockSize,
+			SizeType cacheCapacity = 64,
+			SizeType batchSize     = 16>
+		using TemplatedPolicy = per_cpu_cache::TemplatedPolicy<
+			blockSize, cacheCapacity, batchSize>;
+
+		template <class Backing,
+			SizeType blockSize,
+			SizeType cacheCapacity = 64,
+			SizeType batchSize     = 16>
+		using Templated = per_cpu_cache::Templated<
+			Backing, blockSize, cacheCapacity, batchSize>;
+};
+
+
+	}
+}
+
+#endif
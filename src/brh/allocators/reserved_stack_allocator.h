@@ -0,0 +1,182 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_RESERVED_STACK_ALLOCATOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_RESERVED_STACK_ALLOCATOR_H
+
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <utility>
+
+#include <sys/mman.h>
+
+#include <supports/round_up_to_multiple.h>
+
+#include "common/common_types.h"
+
+#include "mmap_allocator.h"
+#include "stack_allocator.h"
+
+namespace brh {
+	namespace allocators {
+		namespace stack_allocator {
+
+/// Reserves address space up front and commits pages only as the top of
+/// the stack reaches them. The stack never moves, so the top block can
+/// grow in place up to the reservation, and the reservation can be far
+/// larger than the memory that is ever used.
+class ReservedPolicy {
+	public:
+		/// The reserved range, in place of the array of other policies.
+		class Reservation {
+			public:
+				char *       data()       { return data_; }
+				char const * data() const { return data_; }
+				SizeType     size() const { return size_; }
+
+			private:
+				friend class ReservedPolicy;
+
+				char *   data_ {nullptr};
+				SizeType size_ {0};
+		};
+
+		using ArrayType        = Reservation;
+		using ArrayReturn      = ArrayType       &;
+		using ArrayConstReturn = ArrayType const &;
+
+		friend void swap(ReservedPolicy & first, ReservedPolicy & second) {
+			using std::swap;
+
+			swap(first.reservation_,  second.reservation_);
+			swap(first.retainedSize_, second.retainedSize_);
+			swap(first.commitSize_,   second.commitSize_);
+			swap(first.committed_,    second.committed_);
+		}
+
+		/// @param reservedSize The most the stack holds, rounded up to
+		///                     whole pages. Only address space.
+		/// @param retainedSize Stays committed when the stack is reset,
+		///                     everything above is given back. All of it
+		///                     stays by default.
+		/// @param commitSize   The least that is committed at once, to
+		///                     keep system calls rare.
+		///
+		/// @throws std::bad_alloc If the range can't be reserved.
+		ReservedPolicy(SizeType reservedSize,
+		               SizeType retainedSize = std::numeric_limits<SizeType>::max(),
+		               SizeType commitSize   = 64 * 1024) :
+			retainedSize_ {retainedSize},
+			commitSize_   {std::max<SizeType>(commitSize, 1)} {
+
+			auto const size = roundUpToPage(reservedSize == 0 ? 1 : reservedSize);
+
+			auto const ptr = mmap(nullptr, size, PROT_NONE,
+			                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+			                      -1, 0);
+
+			if (ptr == MAP_FAILED)
+				throw std::bad_alloc();
+
+			reservation_.data_ = static_cast<char *>(ptr);
+			reservation_.size_ = size;
+		}
+
+		ReservedPolicy(ReservedPolicy && other) : ReservedPolicy() {
+			swap(*this, other);
+		}
+
+		ReservedPolicy & operator=(ReservedPolicy other) {
+			swap(*this, other);
+			return *this;
+		}
+
+		~ReservedPolicy() {
+			if (reservation_.data_ != nullptr)
+				munmap(reservation_.data_, reservation_.size_);
+		}
+
+		ArrayReturn      getArray()       { return reservation_; }
+		ArrayConstReturn getArray() const { return reservation_; }
+
+		SizeType getStackSize() const { return reservation_.size_; }
+
+		/// The memory that is backed by pages, from the start of the stack.
+		SizeType getCommittedSize() const { return committed_; }
+
+		/// Makes the first size bytes usable.
+		///
+		/// @return false if the kernel refused to commit more.
+		bool commit(SizeType size) {
+			if (size <= committed_)
+				return true;
+
+			auto const target = std::min(
+				roundUpToPage(std::max(size, committed_ + commitSize_)),
+				reservation_.size_
+			);
+
+			if (mprotect(reservation_.data_ + committed_, target - committed_,
+			             PROT_READ | PROT_WRITE) != 0)
+				return false;
+
+			committed_ = target;
+			return true;
+		}
+
+		/// Gives the pages above the retained size back to the kernel.
+		/// Mapping over them drops their contents and their commit charge.
+		void reset() {
+			if (retainedSize_ >= committed_)
+				return;
+
+			auto const retained = roundUpToPage(retainedSize_);
+
+			if (retained >= committed_)
+				return;
+
+			auto const ptr = mmap(reservation_.data_ + retained,
+			                      committed_ - retained, PROT_NONE,
+			                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE |
+			                      MAP_FIXED, -1, 0);
+
+			if (ptr != MAP_FAILED)
+				committed_ = retained;
+		}
+
+
+	private:
+		ReservedPolicy() {}
+
+		static SizeType roundUpToPage(SizeType size) {
+			return supports::roundUpToMultiple(size, MmapAllocator::getPageSize());
+		}
+
+		Reservation reservation_;
+		SizeType    retainedSize_ {0};
+		SizeType    commitSize_   {0};
+		SizeType    committed_    {0};
+};
+
+
+/// Grows in place up to a reservation of address space, committing
+/// memory as it goes.
+using Reserved = Allocator<ReservedPolicy>;
+
+		} // stack_allocator
+
+
+
+/// A StackAllocator over a reservation of address space that commits
+/// pages as the stack grows and can give them back when it is reset.
+class ReservedStackAllocator {
+	public:
+		using Policy    = stack_allocator::ReservedPolicy;
+		using Allocator = stack_allocator::Reserved;
+
+		using WithSizeHeader = stack_allocator::WithSizeHeader<Policy>;
+};
+
+
+	}
+}
+
+#endif
@@ -1,8 +1,13 @@
 #ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_SEGREGATOR_H
 #define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_SEGREGATOR_H
 
+#include <cassert>
+#include <type_traits>
+
 #include "common/common_types.h"
+#include "common/move_block.h"
 #include "blocks/block.h"
+#include "traits/traits.h"
 
 namespace brh {
 	namespace allocators {
@@ -10,17 +15,27 @@ namespace brh {
 
 /// SmallAllocator must not allocate blocks larger than the threshold if
 /// the passed size is less than or equal to the threshold.
+/// Queries such as @ref isEmpty only exist if both children have them.
 template <class t_Policy,
 	        class SmallAllocator,
 		      class LargeAllocator>
 class Allocator : private t_Policy,
                   private SmallAllocator,
                   private LargeAllocator {
+	private:
+		/// Return type that only exists if both children have
+		/// the capability.
+		template <template <class> class Capability, class Type, class Small>
+		using IfBothHave = typename std::enable_if<
+			traits::AllHave<Capability, Small, LargeAllocator>::value, Type
+		>::type;
+
 	public:
 		using Policy = t_Policy;
 
-		constexpr Allocator() : Allocator(SmallAllocator(),
-		                                  LargeAllocator()) {}
+		/// The children are constructed in place, allocators with inline
+		/// arrays can't always be moved safely.
+		constexpr Allocator() {}
 
 		constexpr Allocator(SmallAllocator small,
 		                    LargeAllocator large) :
@@ -43,6 +58,13 @@ class Allocator : private t_Policy,
 			}
 		}
 
+		RawBlock allocateAligned(SizeType size, SizeType alignment) {
+			if (belongsToSmall(size))
+				return traits::allocateAligned(getSmall(), size, alignment);
+			else
+				return traits::allocateAligned(getLarge(), size, alignment);
+		}
+
 		constexpr void deallocate(NullBlock) const {}
 
 		void deallocate(RawBlock block) {
@@ -55,6 +77,9 @@ class Allocator : private t_Policy,
 			}
 		}
 
+		/// Resizes in place through the owning allocator when the new size
+		/// stays on the same side of the threshold, otherwise moves the
+		/// block to the other allocator.
 		bool reallocate(RawBlock & block, SizeType size) {
 			auto blockSize = block.getSize();
 
@@ -62,28 +87,32 @@ class Allocator : private t_Policy,
 				return true;
 
 			if (belongsToSmall(blockSize)) {
-				if (belongsToSmall(size))
-					return SmallAllocator::reallocate(block, size);
+				if (belongsToSmall(size)) {
+					if (traits::reallocate(getSmall(), block, size))
+						return true;
+
+					return reallocateAcrossAllocators<
+						SmallAllocator, SmallAllocator>(block, size);
+				}
 				else {
 					assert(blockSize < size);
-					reallocateAcrossAllocators<SmallAllocator, LargeAllocator>(
-						block, size, blockSize
-					);
-
-					return true;
+					return reallocateAcrossAllocators<
+						SmallAllocator, LargeAllocator>(block, size);
 				}
 			}
 
 			else {
-				if (belongsToLarge(size))
-					return LargeAllocator::reallocate(block, size);
+				if (belongsToLarge(size)) {
+					if (traits::reallocate(getLarge(), block, size))
+						return true;
+
+					return reallocateAcrossAllocators<
+						LargeAllocator, LargeAllocator>(block, size);
+				}
 				else {
 					assert(size < blockSize);
-					reallocateAcrossAllocators<LargeAllocator, SmallAllocator>(
-						block, size, size
-					);
-
-					return true;
+					return reallocateAcrossAllocators<
+						LargeAllocator, SmallAllocator>(block, size);
 				}
 			}
 		}
@@ -97,41 +126,58 @@ class Allocator : private t_Policy,
 
 			if (belongsToSmall(blockSize)) {
 				if (belongsToSmall(newBlockSize))
-					return SmallAllocator::expand(block, amount);
+					return traits::expand(getSmall(), block, amount);
 				else
 					return false;
 			}
 
 			else {
 				if (belongsToLarge(newBlockSize))
-					return LargeAllocator::expand(block, amount);
+					return traits::expand(getLarge(), block, amount);
 				else
 					return false;
 			}
 		}
 
-		bool owns(RawBlock block) const {
-			return (SmallAllocator::owns(block) ||
-				      LargeAllocator::owns(block));
+		template <class Small = SmallAllocator>
+		IfBothHave<traits::HasOwns, bool, Small>
+		owns(RawBlock block) {
+			return (Small::owns(block) ||
+			        LargeAllocator::owns(block));
+		}
+
+		template <class Small = SmallAllocator>
+		IfBothHave<traits::HasDeallocateAll, void, Small>
+		deallocateAll() {
+			Small::deallocateAll();
+			LargeAllocator::deallocateAll();
 		}
 
-		bool isEmpty() const {
-			return (SmallAllocator::isEmpty() &&
+		template <class Small = SmallAllocator>
+		IfBothHave<traits::HasIsEmpty, bool, Small>
+		isEmpty() const {
+			return (Small::isEmpty() &&
 			        LargeAllocator::isEmpty());
 		}
 
-		bool isFull() const {
-			return (SmallAllocator::isFull() &&
+		template <class Small = SmallAllocator>
+		IfBothHave<traits::HasIsFull, bool, Small>
+		isFull() const {
+			return (Small::isFull() &&
 			        LargeAllocator::isFull());
 		}
 
-		SizeType calcUnoccupied() const {
-			return (SmallAllocator::calcUnoccupied() +
+		template <class Small = SmallAllocator>
+		IfBothHave<traits::HasCalcUnoccupied, SizeType, Small>
+		calcUnoccupied() const {
+			return (Small::calcUnoccupied() +
 			        LargeAllocator::calcUnoccupied());
 		}
 
-		SizeType calcOccupied() const {
-			return (SmallAllocator::calcOccupied() +
+		template <class Small = SmallAllocator>
+		IfBothHave<traits::HasCalcOccupied, SizeType, Small>
+		calcOccupied() const {
+			return (Small::calcOccupied() +
 			        LargeAllocator::calcOccupied());
 		}
 
@@ -163,11 +209,10 @@ class Allocator : private t_Policy,
 
 	private:
 		template <class OldOwner, class NewOwner>
-		void reallocateAcrossAllocators(RawBlock & block, SizeType size, SizeType copySize) {
-			auto newBlock = NewOwner::allocate(size);
-			std::memcpy(newBlock.getPtr(), block.getPtr(), copySize);
-			OldOwner::deallocate(block);
-			block = newBlock;
+		bool reallocateAcrossAllocators(RawBlock & block, SizeType size) {
+			return common::moveBlock(static_cast<OldOwner&>(*this),
+			                         static_cast<NewOwner&>(*this),
+			                         block, size);
 		}
 };
 
@@ -0,0 +1,361 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_SHARDED_BITMAPPED_BLOCK_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_SHARDED_BITMAPPED_BLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <functional>
+
+#include <sched.h>
+
+#include <supports/round_up_to_multiple.h>
+
+#include "common/common_types.h"
+#include "common/fast_divisor.h"
+#include "common/move_block.h"
+#include "blocks/block.h"
+#include "traits/traits.h"
+
+#include "bitmapped_block.h"
+#include "multithread/lock.h"
+
+namespace brh {
+	namespace allocators {
+		namespace sharded_bitmapped_block {
+
+/// Picks the shard of the thread by hashing its id. The same thread always
+/// gets the same shard.
+class ThreadShardSelector {
+	public:
+		static SizeType getIndex() {
+			thread_local SizeType const index {
+				std::hash<std::thread::id>()(std::this_thread::get_id())
+			};
+
+			return index;
+		}
+};
+
+/// Picks the shard of the CPU that the thread runs on, so that threads on
+/// different cores rarely share a shard. Falls back to the thread hash if
+/// the CPU can't be queried.
+class CpuShardSelector {
+	public:
+		static SizeType getIndex() {
+			auto const cpu = sched_getcpu();
+
+			if (cpu < 0)
+				return ThreadShardSelector::getIndex();
+			else
+				return static_cast<SizeType>(cpu);
+		}
+};
+
+
+/// Splits one contiguous arena into shards of equal size, each a
+/// BitmappedBlock with its own lock. Threads allocate from their home
+/// shard and only move on to the following shards once it is exhausted.
+/// Blocks go back to their shard, which is found from the address alone.
+template <template <class T> class CoreArray,
+	std::size_t t_alignment,
+	class       t_Placement,
+	class       t_ShardSelector,
+	class       t_Lock = multithread::DefaultLock>
+class Allocator {
+	public:
+		static constexpr std::size_t alignment {t_alignment};
+
+		using Placement     = t_Placement;
+		using ShardSelector = t_ShardSelector;
+		using Lock          = t_Lock;
+		using ShardPolicy   = bitmapped_block::ViewPolicy<alignment>;
+		using Shard         = bitmapped_block::Allocator<
+			ShardPolicy, Placement, bitmapped_block::NoSizeRecovery, Lock>;
+		using Handle        = RawBlock;
+
+		/// @param minimumBlockCount Is split between the shards, every shard
+		///                          gets a multiple of 64 blocks.
+		Allocator(SizeType minimumBlockSize,
+		          SizeType minimumBlockCount,
+		          SizeType shardCount = getDefaultShardCount()) :
+			Allocator(minimumBlockSize, minimumBlockCount,
+			          shardCount == 0 ? 1 : shardCount, 0) {}
+
+		Allocator(Allocator &&) = default;
+		Allocator(Allocator const &) = delete;
+
+
+		static SizeType getDefaultShardCount() {
+			auto const count = std::thread::hardware_concurrency();
+
+			return (count == 0 ? 1 : count);
+		}
+
+		SizeType getShardCount() const {
+			return shards_.size();
+		}
+
+		Shard & getShard(SizeType index) {
+			return shards_[index].shard;
+		}
+
+		Shard const & getShard(SizeType index) const {
+			return shards_[index].shard;
+		}
+
+		SizeType calcRequiredSize(SizeType desiredSize) const {
+			return getShard(0).calcRequiredSize(desiredSize);
+		}
+
+		Handle allocate(SizeType size) {
+			return allocateFromHome([size](Shard & shard) {
+				return shard.allocate(size);
+			});
+		}
+
+		Handle allocateAligned(SizeType size, SizeType alignment) {
+			return allocateFromHome([size, alignment](Shard & shard) {
+				return shard.allocateAligned(size, alignment);
+			});
+		}
+
+		constexpr void deallocate(NullBlock) const {}
+
+		void deallocate(Handle block) {
+			if (owns(block))
+				getOwner(block).deallocate(block);
+		}
+
+		void deallocateAll() {
+			for (auto & padded : shards_)
+				padded.shard.deallocateAll();
+		}
+
+		/// Resizes within the owning shard if it can, otherwise moves the
+		/// block starting from the home shard. Fails for foreign blocks.
+		bool reallocate(Handle & block, SizeType newSize) {
+			if (block.isNull()) {
+				block = allocate(newSize);
+				return !block.isNull();
+			}
+
+			if (!owns(block))
+				return false;
+
+			if (getOwner(block).reallocate(block, newSize))
+				return true;
+
+			return common::moveBlock(*this, *this, block, newSize);
+		}
+
+		/// Blocks never grow across the end of their shard. Fails for
+		/// foreign blocks.
+		bool expand(Handle & block, SizeType amount) {
+			if (!owns(block))
+				return false;
+
+			return getOwner(block).expand(block, amount);
+		}
+
+		bool owns(Handle block) const {
+			auto const ptr = static_cast<ArrayElement const *>(block.getPtr());
+
+			return (ptr >= getStorage() &&
+			        ptr <  getStorage() + shardStorageSize_ * getShardCount());
+		}
+
+		bool isEmpty() const {
+			for (auto const & padded : shards_) {
+				if (!padded.shard.isEmpty())
+					return false;
+			}
+
+			return true;
+		}
+
+		bool isFull() const {
+			for (auto const & padded : shards_) {
+				if (!padded.shard.isFull())
+					return false;
+			}
+
+			return true;
+		}
+
+		SizeType calcOccupied() const {
+			SizeType occupied {0};
+
+			for (auto const & padded : shards_)
+				occupied += padded.shard.calcOccupied();
+
+			return occupied;
+		}
+
+		SizeType calcUnoccupied() const {
+			SizeType unoccupied {0};
+
+			for (auto const & padded : shards_)
+				unoccupied += padded.shard.calcUnoccupied();
+
+			return unoccupied;
+		}
+
+
+	private:
+		using ArrayElement   = bitmapped_block::ArrayElement;
+		using ArrayType      = traits::RuntimeSizedArray<CoreArray, ArrayElement>;
+		using AttributesType = typename ShardPolicy::AttributesType;
+
+		/// Keeps the locks and hints of neighbouring shards on different
+		/// cache lines no matter how the container aligns them.
+		struct PaddedShard {
+			PaddedShard(ShardPolicy policy) : shard(std::move(policy)) {}
+
+			char  padding[cacheLineSize];
+			Shard shard;
+		};
+
+		static constexpr SizeType storageAlignment {
+			alignment > cacheLineSize ? alignment : cacheLineSize
+		};
+
+		Allocator(SizeType minimumBlockSize,
+		          SizeType minimumBlockCount,
+		          SizeType shardCount,
+		          int) :
+			Allocator(AttributesType(
+				minimumBlockSize,
+				supports::roundUpToMultiple(
+					supports::roundUpToMultiple(minimumBlockCount, shardCount) /
+						shardCount,
+					bitmapped_block::metaWordBits
+				)
+			), shardCount) {}
+
+		/// The meta data of every shard takes whole cache lines at the
+		/// start, the blocks of all shards follow as one region.
+		Allocator(AttributesType attributes, SizeType shardCount) :
+			array_ (calcArraySize(attributes, shardCount)),
+			shardStorageSize_ (attributes.getStorageSize()),
+			shardDivisor_     (attributes.getStorageSize()),
+			countDivisor_     (shardCount) {
+			auto const data = reinterpret_cast<std::uintptr_t>(&array_[0]);
+
+			auto const meta = supports::roundUpToMultiple(
+				data, static_cast<std::uintptr_t>(cacheLineSize)
+			);
+
+			auto const storage = supports::roundUpToMultiple(
+				meta + calcMetaSize(attributes) * shardCount,
+				static_cast<std::uintptr_t>(storageAlignment)
+			);
+
+			metaOffset_    = meta    - data;
+			storageOffset_ = storage - data;
+
+			shards_.reserve(shardCount);
+
+			for (SizeType i {0}; i < shardCount; ++i) {
+				shards_.emplace_back(ShardPolicy(
+					attributes,
+					&array_[0] + metaOffset_    + calcMetaSize(attributes) * i,
+					&array_[0] + storageOffset_ + shardStorageSize_        * i
+				));
+			}
+		}
+
+		static SizeType calcMetaSize(AttributesType const & attributes) {
+			return supports::roundUpToMultiple(
+				ShardPolicy::calcMetaSize(attributes), cacheLineSize
+			);
+		}
+
+		static SizeType calcArraySize(AttributesType const & attributes,
+		                              SizeType               shardCount) {
+			return (cacheLineSize - 1) +
+			       calcMetaSize(attributes) * shardCount +
+			       (storageAlignment - 1) +
+			       attributes.getStorageSize() * shardCount;
+		}
+
+		ArrayElement const * getStorage() const {
+			return &array_[0] + storageOffset_;
+		}
+
+		Shard & getOwner(Handle block) {
+			auto const ptr = static_cast<ArrayElement const *>(block.getPtr());
+
+			return getShard(shardDivisor_.divide(ptr - getStorage()));
+		}
+
+		/// Tries the home shard first, then every following shard in turn.
+		template <class Function>
+		Handle allocateFromHome(Function allocateFromShard) {
+			auto const count = getShardCount();
+			auto const home  = countDivisor_.calcRemainder(ShardSelector::getIndex());
+
+			for (SizeType i {0}; i < count; ++i) {
+				auto const index = (home + i < count ? home + i : home + i - count);
+				auto block = allocateFromShard(getShard(index));
+
+				if (!block.isNull())
+					return block;
+			}
+
+			return Handle::makeNullBlock();
+		}
+
+		ArrayType                array_;
+		SizeType                 shardStorageSize_;
+		common::FastDivisor      shardDivisor_;
+		common::FastDivisor      countDivisor_;
+		SizeType                 metaOffset_;
+		SizeType                 storageOffset_;
+		std::vector<PaddedShard> shards_;
+};
+
+
+template <template <class T> class ArrayType,
+	std::size_t alignment     = alignof(std::max_align_t),
+	class       Placement     = bitmapped_block::NextFit,
+	class       ShardSelector = CpuShardSelector,
+	class       Lock          = multithread::DefaultLock>
+using Runtime =
+	Allocator<ArrayType, alignment, Placement, ShardSelector, Lock>;
+
+
+		} // sharded_bitmapped_block
+
+
+
+/// A BitmappedBlock arena split into shards with a lock each, so that
+/// threads on different cores rarely contend.
+class ShardedBitmappedBlock {
+	public:
+		template <template <class T> class ArrayType,
+			std::size_t alignment,
+			class       Placement,
+			class       ShardSelector,
+			class       Lock = multithread::DefaultLock>
+		using Allocator = sharded_bitmapped_block::Allocator<
+			ArrayType, alignment, Placement, ShardSelector, Lock>;
+
+		using CpuShardSelector    = sharded_bitmapped_block::CpuShardSelector;
+		using ThreadShardSelector = sharded_bitmapped_block::ThreadShardSelector;
+
+		template <template <class T> class ArrayType,
+			std::size_t alignment     = alignof(std::max_align_t),
+			class       Placement     = bitmapped_block::NextFit,
+			class       ShardSelector = CpuShardSelector,
+			class       Lock          = multithread::DefaultLock>
+		using Runtime = sharded_bitmapped_block::Runtime<
+			ArrayType, alignment, Placement, ShardSelector, Lock>;
+};
+
+
+	}
+}
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "common/common_types.h"
 #include "blocks/block.h"
+#include "traits/traits.h"
 
 namespace brh {
 	namespace allocators {
@@ -35,9 +36,26 @@ class Allocator : private t_Policy
 			Policy::Allocator::deallocate(block);
 		}
 
+		bool reallocate(RawBlock & block, SizeType newSize) {
+			if (Policy::passes(newSize))
+				return traits::reallocate(getAllocator(), block, newSize);
+			else
+				return false;
+		}
+
+		bool expand(RawBlock & block, SizeType amount) {
+			if (Policy::passes(block.getSize() + amount))
+				return traits::expand(getAllocator(), block, amount);
+			else
+				return false;
+		}
+
 		bool owns(RawBlock block) {
 			return Policy::Allocator::owns(block);
 		}
+
+	private:
+		typename Policy::Allocator & getAllocator() { return *this; }
 };
 
 
@@ -115,9 +133,26 @@ class SizeFailAllocator : private Allocator
 				Allocator::deallocate(block);
 		}
 
+		bool reallocate(RawBlock & block, SizeType newSize) {
+			if (newSize > maxSize)
+				return false;
+			else
+				return traits::reallocate(getAllocator(), block, newSize);
+		}
+
+		bool expand(RawBlock & block, SizeType amount) {
+			if (block.getSize() + amount > maxSize)
+				return false;
+			else
+				return traits::expand(getAllocator(), block, amount);
+		}
+
 		bool owns(RawBlock block) {
 			return (Allocator::owns(block));
 		}
+
+	private:
+		Allocator & getAllocator() { return *this; }
 };
 
 
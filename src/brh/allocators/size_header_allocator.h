@@ -0,0 +1,127 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_SIZE_HEADER_ALLOCATOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_SIZE_HEADER_ALLOCATOR_H
+
+#include <cstring>
+#include <utility>
+
+#include "common/common_types.h"
+#include "blocks/block.h"
+#include "traits/traits.h"
+
+namespace brh {
+	namespace allocators {
+
+/// Stores the size of every block of the underlying allocator in a header
+/// right before the returned pointer, so that blocks can be deallocated
+/// from their pointer alone. For allocators that can't tell the size
+/// themselves, such as StackAllocator.
+///
+/// The header shifts every block by sizeof(SizeType), alignments beyond
+/// that are lost.
+template <class t_Allocator>
+class SizeHeaderAllocator : private t_Allocator
+{
+	public:
+		using Allocator = t_Allocator;
+		using Handle    = RawBlock;
+
+		static constexpr SizeType headerSize {sizeof(SizeType)};
+
+		SizeHeaderAllocator() {}
+
+		SizeHeaderAllocator(Allocator allocator) :
+			Allocator(std::move(allocator)) {}
+
+		Handle allocate(SizeType size) {
+			return wrap(Allocator::allocate(size + headerSize));
+		}
+
+		constexpr void deallocate(NullBlock) const {}
+
+		/// Only the pointer of the block is used.
+		void deallocate(Handle block) {
+			deallocate(block.getPtr());
+		}
+
+		void deallocate(void * ptr) {
+			if (ptr != nullptr)
+				Allocator::deallocate(getInner(ptr));
+		}
+
+		/// @return The block starting at the pointer with the size that
+		///         allocate returned for it.
+		Handle getBlock(void * ptr) const {
+			return {ptr, getInner(ptr).getSize() - headerSize};
+		}
+
+		bool reallocate(Handle & block, SizeType newSize) {
+			return resize(block, [&](Handle & inner) {
+				return traits::reallocate(getAllocator(), inner,
+				                          newSize + headerSize);
+			});
+		}
+
+		bool expand(Handle & block, SizeType amount) {
+			return resize(block, [&](Handle & inner) {
+				return traits::expand(getAllocator(), inner, amount);
+			});
+		}
+
+		/// Only looks at the pointer, the header of a foreign block may not
+		/// be readable.
+		bool owns(Handle block) {
+			if (block.isNull())
+				return false;
+
+			return Allocator::owns({block.getCharPtr() - headerSize, headerSize});
+		}
+
+		void deallocateAll() {
+			Allocator::deallocateAll();
+		}
+
+		bool isEmpty() const {
+			return Allocator::isEmpty();
+		}
+
+
+	private:
+		Allocator & getAllocator() { return *this; }
+
+		static Handle getInner(void * ptr) {
+			auto const inner = static_cast<char *>(ptr) - headerSize;
+
+			SizeType size;
+			std::memcpy(&size, inner, headerSize);
+
+			return {inner, size};
+		}
+
+		/// Writes the header, the inner block may have moved.
+		static Handle wrap(Handle inner) {
+			if (inner.isNull())
+				return Handle::makeNullBlock();
+
+			auto const size = inner.getSize();
+			std::memcpy(inner.getPtr(), &size, headerSize);
+
+			return {inner.getCharPtr() + headerSize, size - headerSize};
+		}
+
+		template <class Function>
+		bool resize(Handle & block, Function resizeInner) {
+			auto inner = getInner(block.getPtr());
+
+			if (!resizeInner(inner))
+				return false;
+
+			block = wrap(inner);
+			return true;
+		}
+};
+
+
+	}
+}
+
+#endif
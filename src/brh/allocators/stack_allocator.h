@@ -1,12 +1,17 @@
 #ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_STACK_ALLOCATOR_H
 #define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_STACK_ALLOCATOR_H
 
-#include <supports/calc_is_aligned.h>
+#include <cstdint>
+#include <utility>
+
+#include <supports/round_up_to_multiple.h>
 
 #include "blocks/block.h"
 #include "common/common_types.h"
 #include "traits/traits.h"
 
+#include "size_header_allocator.h"
+
 namespace brh {
 	namespace allocators {
 		namespace stack_allocator {
@@ -23,6 +28,10 @@ class Allocator : private t_Policy
 		Allocator(Policy policy) : Policy (std::move(policy)),
 		                           next_  {getBegin()} {}
 
+		/// The top of the stack is kept relative to the moved array.
+		Allocator(Allocator && other) :
+			Allocator(std::move(other), other.calcOccupied()) {}
+
 		/// Does nothing but turn it into 1 if it's 0.
 		static constexpr SizeType calcRequiredSize(SizeType desiredSize) {
 			if (desiredSize == 0)
@@ -39,7 +48,8 @@ class Allocator : private t_Policy
 		Handle allocate(SizeType size) {
 			size = calcRequiredSize(size);
 
-			if (next_ <= getEnd() - size) {
+			if (next_ <= getEnd() - size &&
+			    Policy::commit(calcOccupied() + size)) {
 				auto ptr = next_;
 				next_ += size;
 				return {ptr, size};
@@ -49,23 +59,42 @@ class Allocator : private t_Policy
 			}
 		}
 
+		/// Skips ahead to the next aligned address. The skipped bytes are
+		/// only freed along with the blocks below them.
 		Handle allocateAligned(SizeType size, SizeType alignment) {
-			if (supports::calcIsAligned(next_, alignment))
-				return allocate(size);
-
-			else
+			auto const address = reinterpret_cast<std::uintptr_t>(next_);
+			auto const padding = static_cast<SizeType>(
+				supports::roundUpToMultiple(
+					address, static_cast<std::uintptr_t>(alignment)
+				) - address
+			);
+
+			if (padding > calcUnoccupied())
 				return Handle::makeNullBlock();
+
+			auto const previous = next_;
+			next_ += padding;
+
+			auto const block = allocate(size);
+
+			if (block.isNull())
+				next_ = previous;
+
+			return block;
 		}
 
 		/// Effectively deallocates and then allocates the whole container.
 		Handle allocateAll() {
+			if (!Policy::commit(Policy::getStackSize()))
+				return Handle::makeNullBlock();
+
 			next_ = getEnd();
 			return {getBegin(), getEnd() - getBegin()};
 		}
 
 		/// Allocates everything after the top of the stack.
 		Handle allocateRemaining() {
-			if (!isFull()) {
+			if (!isFull() && Policy::commit(Policy::getStackSize())) {
 				auto ptr = next_;
 				next_ = getEnd();
 				return {ptr, getEnd() - ptr};
@@ -95,9 +124,11 @@ class Allocator : private t_Policy
 			next_ = static_cast<ElementPtr>(ptr);
 		}
 
-		/// Resets the stack.
+		/// Resets the stack. Policies that commit memory on demand may
+		/// give some of it back.
 		void deallocateAll() {
 			next_ = getBegin();
+			Policy::reset();
 		}
 
 		/// Only works if the block is on top or the new size is
@@ -114,7 +145,7 @@ class Allocator : private t_Policy
 					return true;
 				}
 
-				else if (blockSize > newSize){
+				else if (newSize > blockSize) {
 					auto difference = newSize - blockSize;
 					return expandTop(block, difference);
 				}
@@ -175,8 +206,13 @@ class Allocator : private t_Policy
 		using ElementPtr       = ElementType       *;
 		using ElementConstPtr  = ElementType const *;
 
+		Allocator(Allocator && other, SizeType occupied) :
+			Policy (std::move(static_cast<Policy&>(other))),
+			next_  {getBegin() + occupied} {}
+
 		bool expandTop(Handle & block, SizeType amount) {
-			if (calcOccupied() >= amount) {
+			if (calcUnoccupied() >= amount &&
+			    Policy::commit(calcOccupied() + amount)) {
 				block.setSize(block.getSize() + amount);
 				next_ += amount;
 
@@ -215,6 +251,10 @@ class RuntimePolicy :
 
 		SizeType getStackSize() const { return BaseType::getArray().size(); }
 
+		/// The whole array is always usable.
+		static constexpr bool commit(SizeType) { return true; }
+		static void reset() {}
+
 	private:
 		using BaseType = traits::ArrayPolicyInterface<CoreArray, char>;
 };
@@ -230,6 +270,10 @@ class TemplatedPolicy :
 
 	public:
 		static constexpr SizeType getStackSize() { return stackSize; }
+
+		/// The whole array is always usable.
+		static constexpr bool commit(SizeType) { return true; }
+		static void reset() {}
 };
 
 
@@ -245,6 +289,10 @@ using Templated = Allocator<
 	TemplatedPolicy<CoreArray, stackSize>
 >;
 
+/// Blocks carry their size and can be deallocated from their pointer.
+template <class Policy>
+using WithSizeHeader = SizeHeaderAllocator<Allocator<Policy> >;
+
 		} // stack_allocator
 
 
@@ -265,12 +313,16 @@ class StackAllocator {
 			stack_allocator::TemplatedPolicy<CoreArray, stackSize>;
 
 
+
 		template <template <class> class CoreArray>
 		using Runtime = stack_allocator::Runtime<CoreArray>;
 
 		template <template <class T, SizeType size> class CoreArray,
 			SizeType stackSize>
 		using Templated = stack_allocator::Templated<CoreArray, stackSize>;
+
+		template <class Policy>
+		using WithSizeHeader = stack_allocator::WithSizeHeader<Policy>;
 };
 
 
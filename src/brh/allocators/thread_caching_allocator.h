@@ -0,0 +1,465 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_THREAD_CACHING_ALLOCATOR_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_THREAD_CACHING_ALLOCATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include <supports/round_up_to_multiple.h>
+
+#include "common/common_types.h"
+#include "common/move_block.h"
+#include "blocks/block.h"
+#include "traits/traits.h"
+
+#include "full_free_list.h"
+#include "bitmapped_block.h"
+#include "malloc_allocator.h"
+#include "mmap_allocator.h"
+#include "wrappers/allocator_singleton.h"
+
+#include "multithread/lock.h"
+#include "multithread/thread_links.h"
+
+namespace brh {
+	namespace allocators {
+		namespace thread_caching {
+
+/// A FullFreeList for every size class, each linking the blocks of one
+/// slab. Class sizes start at blockSize and double from one to the next.
+/// The lists are lock free, the owning thread takes blocks while other
+/// threads give theirs back.
+template <SizeType blockSize, SizeType classCount>
+class SizeClassLists {
+	private:
+		using List = FullFreeList::View<
+			blockSize, alignof(std::max_align_t), multithread::LockFree>;
+		using Rest = SizeClassLists<blockSize * 2, classCount - 1>;
+
+	public:
+		SizeClassLists(char * slabs, SizeType slabSize) :
+			list_ (typename List::Policy(slabs, slabSize / blockSize)),
+			rest_ (slabs + slabSize, slabSize) {}
+
+		void * allocate(SizeType sizeClass) {
+			if (sizeClass == 0)
+				return list_.allocate();
+			else
+				return rest_.allocate(sizeClass - 1);
+		}
+
+		void deallocate(SizeType sizeClass, void * ptr) {
+			if (sizeClass == 0)
+				list_.deallocate(ptr);
+			else
+				rest_.deallocate(sizeClass - 1, ptr);
+		}
+
+
+	private:
+		static_assert(List::Policy::getBlockSize() == blockSize,
+		              "Size classes must be multiples of the alignment");
+
+		List list_;
+		Rest rest_;
+};
+
+template <SizeType blockSize>
+class SizeClassLists<blockSize, 0> {
+	public:
+		SizeClassLists(char *, SizeType) {}
+
+		void * allocate(SizeType) { return nullptr; }
+		void deallocate(SizeType, void *) {}
+};
+
+
+/// @tparam smallestClass  Block size of the first size class, every
+///                        following class doubles it.
+/// @tparam slabSize       Bytes that every size class of every thread
+///                        cache links, must be a power of 2.
+/// @tparam cacheCount     The most threads that get a cache at once, the
+///                        rest allocate from the central pool.
+/// @tparam mediumMaxSize  Sizes up to this go to the central pool, larger
+///                        ones to LargeAllocator.
+template <SizeType t_smallestClass     = 16,
+          SizeType t_classCount        = 5,
+          SizeType t_slabSize          = 64 * 1024,
+          SizeType t_cacheCount        = 64,
+          SizeType t_mediumBlockSize   = 256,
+          SizeType t_mediumBlockCount  = 16 * 1024,
+          SizeType t_mediumMaxSize     = 32 * 1024,
+          class    t_LargeAllocator    = MallocAllocator>
+class TemplatedPolicy {
+	public:
+		using LargeAllocator = t_LargeAllocator;
+
+		static constexpr SizeType getSmallestClass()    { return t_smallestClass; }
+		static constexpr SizeType getClassCount()       { return t_classCount; }
+		static constexpr SizeType getSlabSize()         { return t_slabSize; }
+		static constexpr SizeType getCacheCount()       { return t_cacheCount; }
+		static constexpr SizeType getMediumBlockSize()  { return t_mediumBlockSize; }
+		static constexpr SizeType getMediumBlockCount() { return t_mediumBlockCount; }
+		static constexpr SizeType getMediumMaxSize()    { return t_mediumMaxSize; }
+
+		static constexpr SizeType getSmallMaxSize() {
+			return t_smallestClass << (t_classCount - 1);
+		}
+
+		static_assert((t_slabSize & (t_slabSize - 1)) == 0,
+		              "The slab size must be a power of 2");
+
+		static_assert(t_smallestClass << (t_classCount - 1) <= t_slabSize,
+		              "Every slab must hold at least one block");
+};
+
+
+/// A general purpose allocator for concurrent use, assembled from the
+/// other allocators.
+///
+/// Small sizes come from the thread's cache, a FullFreeList per size
+/// class over slabs of one reservation. The slab and so the owning cache
+/// and class of a block follow from its address, so any thread can free
+/// any block. Medium sizes and overflow from the caches go to a central
+/// BitmappedBlock at the end of the same reservation, large sizes to
+/// LargeAllocator. Nothing but LargeAllocator uses the heap, so with
+/// MmapAllocator as the large allocator the whole allocator can stand in
+/// for malloc.
+///
+/// Caches of exited threads are handed to new threads along with their
+/// blocks. Meant to be used through one instance, see
+/// @ref ThreadCachingAllocator::Singleton. Threads may outlive an
+/// instance, but must not use it after it is destroyed.
+template <class t_Policy>
+class Allocator : private t_Policy::LargeAllocator {
+	public:
+		using Policy         = t_Policy;
+		using Handle         = RawBlock;
+		using LargeAllocator = typename Policy::LargeAllocator;
+
+		Allocator() :
+			region_ (MmapAllocator().allocate(getRegionSize())),
+			medium_ (makeMediumPolicy(region_)) {
+			for (SizeType i {0}; i < Policy::getCacheCount(); ++i)
+				freeCaches_[i] = Policy::getCacheCount() - 1 - i;
+
+			// Without the region every thread uses the central pool.
+			freeCacheCount_ = (region_.isNull() ? 0 : Policy::getCacheCount());
+		}
+
+		Allocator(Allocator const &) = delete;
+
+		~Allocator() {
+			handles_.unlinkAll([](ThreadHandle &) {});
+
+			for (SizeType i {0}; i < Policy::getCacheCount(); ++i) {
+				if (constructed_[i])
+					getCache(i).~Cache();
+			}
+
+			MmapAllocator().deallocate(region_);
+		}
+
+		Handle allocate(SizeType size) {
+			if (size <= Policy::getSmallMaxSize()) {
+				auto cache = acquireCache();
+
+				if (cache != nullptr) {
+					auto ptr = cache->allocate(calcSizeClass(size));
+
+					if (ptr != nullptr)
+						return {ptr, size};
+				}
+			}
+
+			if (size <= Policy::getMediumMaxSize()) {
+				auto block = medium_.allocate(size);
+
+				if (!block.isNull())
+					return block;
+			}
+
+			return getLarge().allocate(size);
+		}
+
+		constexpr void deallocate(NullBlock) const {}
+
+		void deallocate(Handle block) {
+			if (block.isNull())
+				return;
+
+			if (inRegion(block)) {
+				auto const slab = calcSlabIndex(block);
+
+				getCache(slab / Policy::getClassCount()).deallocate(
+					slab % Policy::getClassCount(), block.getPtr()
+				);
+			}
+
+			else if (medium_.owns(block))
+				medium_.deallocate(block);
+
+			else
+				getLarge().deallocate(block);
+		}
+
+		/// Resizes in place when the block's size class or allocator can
+		/// hold the new size, otherwise moves the block.
+		bool reallocate(Handle & block, SizeType newSize) {
+			if (block.isNull()) {
+				block = allocate(newSize);
+				return !block.isNull();
+			}
+
+			if (inRegion(block)) {
+				auto const sizeClass = calcSlabIndex(block) % Policy::getClassCount();
+
+				if (newSize <= (Policy::getSmallestClass() << sizeClass)) {
+					block.setSize(newSize);
+					return true;
+				}
+			}
+
+			else if (medium_.owns(block)) {
+				if (newSize <= Policy::getMediumMaxSize() &&
+				    medium_.reallocate(block, newSize))
+					return true;
+			}
+
+			else if (newSize > Policy::getMediumMaxSize()) {
+				if (traits::reallocate(getLarge(), block, newSize))
+					return true;
+			}
+
+			return common::moveBlock(*this, *this, block, newSize);
+		}
+
+		bool owns(Handle block) {
+			return (inRegion(block) || medium_.owns(block));
+		}
+
+		/// Takes every lock, so that a child forked in between finds none
+		/// of them held by a thread it doesn't have. The lock free caches
+		/// are consistent at every moment and need none.
+		void lockAll() {
+			multithread::ThreadLinks<ThreadHandle>::lock();
+			cacheMutex_.lock();
+			medium_.lock();
+		}
+
+		/// Releases the locks of lockAll, in the parent and the child.
+		void unlockAll() {
+			medium_.unlock();
+			cacheMutex_.unlock();
+			multithread::ThreadLinks<ThreadHandle>::unlock();
+		}
+
+
+	private:
+		using Cache = SizeClassLists<
+			Policy::getSmallestClass(), Policy::getClassCount()>;
+
+		using MediumPolicy = bitmapped_block::ViewPolicy<alignof(std::max_align_t)>;
+		using Medium       = bitmapped_block::Allocator<
+			MediumPolicy, bitmapped_block::NextFit,
+			bitmapped_block::NoSizeRecovery, multithread::MutexLock>;
+		using ArrayElement = bitmapped_block::ArrayElement;
+
+		static constexpr SizeType noCache {~SizeType {0}};
+
+		/// Gives the cache back when the thread exits, if the instance still
+		/// lives. Owner and index are only valid while linked.
+		struct ThreadHandle : multithread::ThreadLink<ThreadHandle> {
+			~ThreadHandle() {
+				using Links = multithread::ThreadLinks<ThreadHandle>;
+
+				Links::unlink(*this, [](ThreadHandle & handle) {
+					if (handle.index != noCache)
+						handle.owner->releaseCache(handle.index);
+				});
+			}
+
+			Allocator * owner {nullptr};
+			SizeType    index {noCache};
+		};
+
+		/// Padded so that caches used by different threads don't share
+		/// cache lines.
+		using CacheStorage = typename std::aligned_storage<
+			sizeof(Cache), cacheLineSize>::type;
+
+		static constexpr SizeType getSlabsSize() {
+			return Policy::getCacheCount() *
+			       Policy::getClassCount() *
+			       Policy::getSlabSize();
+		}
+
+		static constexpr typename MediumPolicy::AttributesType
+		getMediumAttributes() {
+			return {Policy::getMediumBlockSize(), Policy::getMediumBlockCount()};
+		}
+
+		/// The meta data of the central pool follows the slabs on whole
+		/// cache lines, its blocks come after.
+		static constexpr SizeType getMediumMetaSize() {
+			return supports::roundUpToMultiple(
+				MediumPolicy::calcMetaSize(getMediumAttributes()), cacheLineSize
+			);
+		}
+
+		static constexpr SizeType getRegionSize() {
+			return getSlabsSize() +
+			       getMediumMetaSize() +
+			       getMediumAttributes().getStorageSize();
+		}
+
+		/// Without the region the central pool has no blocks.
+		static MediumPolicy makeMediumPolicy(RawBlock region) {
+			if (region.isNull())
+				return {{Policy::getMediumBlockSize(), 0}, nullptr, nullptr};
+
+			auto const meta = reinterpret_cast<ArrayElement *>(
+				region.getCharPtr() + getSlabsSize()
+			);
+
+			return {getMediumAttributes(), meta, meta + getMediumMetaSize()};
+		}
+
+		static ThreadHandle & getThreadHandle() {
+			static thread_local ThreadHandle handle;
+			return handle;
+		}
+
+		static SizeType calcSizeClass(SizeType size) {
+			SizeType sizeClass {0};
+			SizeType classSize {Policy::getSmallestClass()};
+
+			while (classSize < size) {
+				classSize <<= 1;
+				++sizeClass;
+			}
+
+			return sizeClass;
+		}
+
+		/// @return nullptr if the thread has no cache of this allocator.
+		Cache * acquireCache() {
+			auto & handle = getThreadHandle();
+
+			if (handle.isLinkedTo(handles_)) {
+				if (handle.index == noCache)
+					return nullptr;
+				else
+					return &getCache(handle.index);
+			}
+
+			// The thread already holds a cache of another instance.
+			if (!handles_.link(handle))
+				return nullptr;
+
+			handle.owner = this;
+			handle.index = noCache;
+
+			std::lock_guard<std::mutex> lock {cacheMutex_};
+
+			if (freeCacheCount_ == 0)
+				return nullptr;
+
+			auto const index = freeCaches_[--freeCacheCount_];
+
+			if (!constructed_[index]) {
+				new (&caches_[index]) Cache(
+					region_.getCharPtr() +
+						index * Policy::getClassCount() * Policy::getSlabSize(),
+					Policy::getSlabSize()
+				);
+
+				constructed_[index] = true;
+			}
+
+			handle.index = index;
+			return &getCache(index);
+		}
+
+		void releaseCache(SizeType index) {
+			std::lock_guard<std::mutex> lock {cacheMutex_};
+
+			freeCaches_[freeCacheCount_++] = index;
+		}
+
+		Cache & getCache(SizeType index) {
+			return *reinterpret_cast<Cache *>(&caches_[index]);
+		}
+
+		bool inRegion(Handle block) const {
+			auto const ptr = block.getCharPtr();
+
+			return (!region_.isNull() &&
+			        ptr >= region_.getCharPtr() &&
+			        ptr <  region_.getCharPtr() + getSlabsSize());
+		}
+
+		SizeType calcSlabIndex(Handle block) const {
+			return static_cast<SizeType>(
+				block.getCharPtr() - region_.getCharPtr()
+			) / Policy::getSlabSize();
+		}
+
+		LargeAllocator & getLarge() {
+			return static_cast<LargeAllocator &>(*this);
+		}
+
+		RawBlock region_;
+		Medium   medium_;
+
+		std::mutex                                   cacheMutex_;
+		std::array<SizeType, Policy::getCacheCount()> freeCaches_;
+		SizeType                                     freeCacheCount_;
+		std::array<bool, Policy::getCacheCount()>     constructed_ {};
+
+		std::array<CacheStorage, Policy::getCacheCount()> caches_;
+
+		multithread::ThreadLinks<ThreadHandle> handles_;
+};
+
+
+using Default = Allocator<TemplatedPolicy<> >;
+
+		} // thread_caching
+
+
+
+/// A general purpose allocator for multithreaded programs, built from
+/// per-thread caches of FullFreeLists, a central BitmappedBlock and
+/// a large allocator.
+class ThreadCachingAllocator {
+	public:
+		template <class Policy>
+		using Allocator = thread_caching::Allocator<Policy>;
+
+		template <SizeType smallestClass     = 16,
+		          SizeType classCount        = 5,
+		          SizeType slabSize          = 64 * 1024,
+		          SizeType cacheCount        = 64,
+		          SizeType mediumBlockSize   = 256,
+		          SizeType mediumBlockCount  = 16 * 1024,
+		          SizeType mediumMaxSize     = 32 * 1024,
+		          class    LargeAllocator    = MallocAllocator>
+		using TemplatedPolicy = thread_caching::TemplatedPolicy<
+			smallestClass, classCount, slabSize, cacheCount,
+			mediumBlockSize, mediumBlockCount, mediumMaxSize, LargeAllocator>;
+
+		using Default = thread_caching::Default;
+
+		/// Process wide instance of the default configuration.
+		using Singleton = AllocatorSingleton<Default>;
+};
+
+
+	}
+}
+
+#endif
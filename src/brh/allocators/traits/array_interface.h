@@ -1,6 +1,9 @@
 #ifndef BRH_CPP_ALLOCATORS_BRIDGERRHOLT_ALLOCATORS_TRAITS_ARRAY_INTERFACE_H
 #define BRH_CPP_ALLOCATORS_BRIDGERRHOLT_ALLOCATORS_TRAITS_ARRAY_INTERFACE_H
 
+#include <memory>
+#include <new>
+#include <utility>
 #include <vector>
 
 namespace brh {
@@ -8,12 +11,43 @@ namespace brh {
 		namespace traits {
 
 
+/// Default initialises where std::allocator value initialises, which
+/// leaves trivial elements unwritten.
+template <class T>
+class DefaultInitAllocator : public std::allocator<T>
+{
+	public:
+		template <class U>
+		struct rebind { using other = DefaultInitAllocator<U>; };
+
+		DefaultInitAllocator() = default;
+
+		template <class U>
+		DefaultInitAllocator(DefaultInitAllocator<U> const &) noexcept {}
+
+		template <class U>
+		void construct(U * ptr) {
+			::new (static_cast<void *>(ptr)) U;
+		}
+
+		template <class U, class ... ArgTypes>
+		void construct(U * ptr, ArgTypes && ... args) {
+			::new (static_cast<void *>(ptr)) U(std::forward<ArgTypes>(args)...);
+		}
+};
+
+
 class VectorInterface
 {
 	public:
 		template <class T>
 		using Runtime = std::vector<T>;
 
+		/// Elements of trivial types are left unwritten, so a large array
+		/// only gets pages once they are used.
+		template <class T>
+		using Uninitialized = std::vector<T, DefaultInitAllocator<T> >;
+
 		template <class T, std::size_t size>
 		class Templated : public Runtime<T> {
 			public:
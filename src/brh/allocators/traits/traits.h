@@ -2,13 +2,260 @@
 #define BRH_CPP_ALLOCATORS_BRIDGERRHOLT_ALLOCATORS_TRAITS_H
 
 #include <utility>
+#include <type_traits>
+#include <cstdint>
 
 #include "../common/common_types.h"
+#include "../blocks/block.h"
 
 namespace brh {
 	namespace allocators {
 		namespace traits {
 
+template <class ... Types>
+struct MakeVoid { using Type = void; };
+
+/// Equivalent of C++17's std::void_t, used for detecting members.
+template <class ... Types>
+using VoidType = typename MakeVoid<Types...>::Type;
+
+
+template <class Void, template <class...> class Operation, class ... Args>
+struct Detector : std::false_type {};
+
+template <template <class...> class Operation, class ... Args>
+struct Detector<VoidType<Operation<Args...> >, Operation, Args...> :
+	std::true_type {};
+
+/// Whether Operation<Args...> is a valid type.
+template <template <class...> class Operation, class ... Args>
+using IsDetected = Detector<void, Operation, Args...>;
+
+
+template <class Allocator>
+using OwnsOperation = decltype(
+	std::declval<Allocator&>().owns(std::declval<RawBlock>())
+);
+
+template <class Allocator>
+using ExpandOperation = decltype(
+	std::declval<Allocator&>().expand(
+		std::declval<RawBlock&>(), std::declval<SizeType>()
+	)
+);
+
+template <class Allocator>
+using ReallocateOperation = decltype(
+	std::declval<Allocator&>().reallocate(
+		std::declval<RawBlock&>(), std::declval<SizeType>()
+	)
+);
+
+template <class Allocator>
+using AllocateAlignedOperation = decltype(
+	std::declval<Allocator&>().allocateAligned(
+		std::declval<SizeType>(), std::declval<SizeType>()
+	)
+);
+
+template <class Allocator>
+using AllocateAllOperation = decltype(
+	std::declval<Allocator&>().allocateAll()
+);
+
+template <class Allocator>
+using DeallocateAllOperation = decltype(
+	std::declval<Allocator&>().deallocateAll()
+);
+
+template <class Allocator>
+using GetBlockAlignmentOperation = decltype(
+	std::declval<Allocator const &>().getBlockAlignment()
+);
+
+template <class Allocator>
+using IsEmptyOperation = decltype(
+	std::declval<Allocator const &>().isEmpty()
+);
+
+template <class Allocator>
+using IsFullOperation = decltype(
+	std::declval<Allocator const &>().isFull()
+);
+
+template <class Allocator>
+using CalcOccupiedOperation = decltype(
+	std::declval<Allocator const &>().calcOccupied()
+);
+
+template <class Allocator>
+using CalcUnoccupiedOperation = decltype(
+	std::declval<Allocator const &>().calcUnoccupied()
+);
+
+
+/// Whether the allocator can tell if it owns a block.
+template <class Allocator>
+using HasOwns = IsDetected<OwnsOperation, Allocator>;
+
+/// Whether the allocator can try to grow a block in place.
+template <class Allocator>
+using HasExpand = IsDetected<ExpandOperation, Allocator>;
+
+template <class Allocator>
+using HasReallocate = IsDetected<ReallocateOperation, Allocator>;
+
+template <class Allocator>
+using HasAllocateAligned = IsDetected<AllocateAlignedOperation, Allocator>;
+
+template <class Allocator>
+using HasAllocateAll = IsDetected<AllocateAllOperation, Allocator>;
+
+template <class Allocator>
+using HasDeallocateAll = IsDetected<DeallocateAllOperation, Allocator>;
+
+template <class Allocator>
+using HasGetBlockAlignment = IsDetected<GetBlockAlignmentOperation, Allocator>;
+
+template <class Allocator>
+using HasIsEmpty = IsDetected<IsEmptyOperation, Allocator>;
+
+template <class Allocator>
+using HasIsFull = IsDetected<IsFullOperation, Allocator>;
+
+template <class Allocator>
+using HasCalcOccupied = IsDetected<CalcOccupiedOperation, Allocator>;
+
+template <class Allocator>
+using HasCalcUnoccupied = IsDetected<CalcUnoccupiedOperation, Allocator>;
+
+/// Whether every allocator has the capability.
+template <template <class> class Capability, class ... Allocators>
+struct AllHave;
+
+template <template <class> class Capability>
+struct AllHave<Capability> : std::true_type {};
+
+template <template <class> class Capability, class First, class ... Rest>
+struct AllHave<Capability, First, Rest...> : std::integral_constant<bool,
+	Capability<First>::value && AllHave<Capability, Rest...>::value
+> {};
+
+
+// The functions below pick the best available operation at compile time.
+// Overloads taking std::true_type/std::false_type are selected by
+// the matching capability.
+
+template <class Allocator>
+bool expand(std::true_type, Allocator & allocator,
+            RawBlock & block, SizeType amount) {
+	return allocator.expand(block, amount);
+}
+
+template <class Allocator>
+constexpr bool expand(std::false_type, Allocator &,
+                      RawBlock &, SizeType amount) {
+	return (amount == 0);
+}
+
+/// Grows the block in place, fails if the allocator can't expand.
+template <class Allocator>
+bool expand(Allocator & allocator, RawBlock & block, SizeType amount) {
+	return expand(HasExpand<Allocator>(), allocator, block, amount);
+}
+
+
+template <class Allocator>
+bool reallocate(std::true_type, Allocator & allocator,
+                RawBlock & block, SizeType newSize) {
+	return allocator.reallocate(block, newSize);
+}
+
+template <class Allocator>
+bool reallocate(std::false_type, Allocator & allocator,
+                RawBlock & block, SizeType newSize) {
+	auto const blockSize = block.getSize();
+
+	if (newSize == blockSize)
+		return true;
+
+	// Shrinking in place would lose the size the allocator expects back.
+	if (newSize < blockSize)
+		return false;
+
+	return expand(allocator, block, newSize - blockSize);
+}
+
+/// Uses the allocator's own reallocate, otherwise tries to grow in place.
+/// Fails without touching the block if neither works.
+template <class Allocator>
+bool reallocate(Allocator & allocator, RawBlock & block, SizeType newSize) {
+	return reallocate(HasReallocate<Allocator>(), allocator, block, newSize);
+}
+
+
+template <class Allocator>
+RawBlock allocateAligned(std::true_type, Allocator & allocator,
+                         SizeType size, SizeType alignment) {
+	return allocator.allocateAligned(size, alignment);
+}
+
+template <class Allocator>
+RawBlock allocateAligned(std::false_type, Allocator & allocator,
+                         SizeType size, SizeType alignment) {
+	RawBlock block {allocator.allocate(size)};
+
+	if (reinterpret_cast<std::uintptr_t>(block.getPtr()) % alignment == 0)
+		return block;
+
+	allocator.deallocate(block);
+	return RawBlock::makeNullBlock();
+}
+
+/// Allocators without allocateAligned only succeed if the regular
+/// allocation happens to be aligned.
+template <class Allocator>
+RawBlock allocateAligned(Allocator & allocator,
+                         SizeType    size,
+                         SizeType    alignment) {
+	return allocateAligned(
+		HasAllocateAligned<Allocator>(), allocator, size, alignment
+	);
+}
+
+template <class Allocator>
+void deallocateAll(std::true_type, Allocator & allocator) {
+	allocator.deallocateAll();
+}
+
+template <class Allocator>
+void deallocateAll(std::false_type, Allocator &) {}
+
+/// Resets allocators that have deallocateAll, does nothing for others.
+template <class Allocator>
+void deallocateAll(Allocator & allocator) {
+	deallocateAll(HasDeallocateAll<Allocator>(), allocator);
+}
+
+
+template <class Allocator>
+SizeType getBlockAlignment(std::true_type, Allocator const & allocator) {
+	return allocator.getBlockAlignment();
+}
+
+template <class Allocator>
+constexpr SizeType getBlockAlignment(std::false_type, Allocator const &) {
+	return 1;
+}
+
+/// The alignment that every block of the allocator has, 1 if the
+/// allocator doesn't tell.
+template <class Allocator>
+SizeType getBlockAlignment(Allocator const & allocator) {
+	return getBlockAlignment(HasGetBlockAlignment<Allocator>(), allocator);
+}
+
+
 template <template <class T> class ArrayType, class T>
 class RuntimeSizedArray : public ArrayType<T>
 {
@@ -1,10 +1,12 @@
 #ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_WRAPPERS_ALLOCATOR_WRAPPER_H
 #define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_WRAPPERS_ALLOCATOR_WRAPPER_H
 
+#include <new>
 #include <utility>
 #include <stdexcept>
 
 #include "../blocks/block.h"
+#include "../traits/traits.h"
 
 namespace brh {
 	namespace allocators {
@@ -17,14 +19,26 @@ class AllocatorWrapper : public Allocator
 		using BlockType = BasicBlock<T>;
 
 		template <class ... ArgTypes>
-		AllocatorWrapper(ArgTypes ... args) : Allocator {std::forward(args)...} {}
+		AllocatorWrapper(ArgTypes ... args) : Allocator {std::forward<ArgTypes>(args)...} {}
 
 		/// Constructs the template type using placement new and
-		/// the passed arguments.
+		/// the passed arguments, in a block aligned for the type. Only
+		/// types aligned beyond what every block of the allocator has go
+		/// through allocateAligned.
 		/// Raw arrays are not supported (use std::array instead).
+		///
+		/// @throws std::bad_alloc If no suitable block could be allocated.
 		template <class T, class ... ArgTypes>
 		BlockType<T> construct(ArgTypes ... args) {
-			RawBlock block = Allocator::allocate(sizeof(T));
+			Allocator & allocator = *this;
+
+			RawBlock block = (alignof(T) <= traits::getBlockAlignment(allocator) ?
+				allocator.allocate(sizeof(T)) :
+				traits::allocateAligned(allocator, sizeof(T), alignof(T)));
+
+			if (block.isNull())
+				throw std::bad_alloc();
+
 			T * ptr = new (block.getPtr()) T {std::forward<ArgTypes>(args)...};
 			return { ptr, block.getSize() };
 		}
@@ -43,7 +57,7 @@ class BlockAllocatorWrapper : public Allocator
 {
 	public:
 		template <class ... ArgTypes>
-		BlockAllocatorWrapper(ArgTypes ... args) : Allocator {std::forward(args)...} {}
+		BlockAllocatorWrapper(ArgTypes ... args) : Allocator {std::forward<ArgTypes>(args)...} {}
 
 		template <class T, class ... ArgTypes>
 		T * construct(ArgTypes ... args) {
@@ -72,7 +86,7 @@ class BlockAllocatorRegularInterface :
 
 		template <class ... ArgTypes>
 		BlockAllocatorRegularInterface(ArgTypes ... args) :
-			AllocatorType {std::forward(args)...} {}
+			AllocatorType {std::forward<ArgTypes>(args)...} {}
 
 		template <class T, class ... ArgTypes>
 		BasicBlock<T> construct(ArgTypes ... args) {
@@ -94,6 +108,22 @@ class BlockAllocatorRegularInterface :
 			AllocatorType::deallocate(block.getPtr());
 		}
 
+		void deallocate(void * ptr) {
+			AllocatorType::deallocate(ptr);
+		}
+
+		RawBlock getBlock(void * ptr) const {
+			return AllocatorType::getBlock(ptr);
+		}
+
+		bool reallocate(RawBlock & block, SizeType newSize) {
+			return AllocatorType::reallocate(block, newSize);
+		}
+
+		bool expand(RawBlock & block, SizeType amount) {
+			return AllocatorType::expand(block, amount);
+		}
+
 		bool owns(RawBlock block) {
 			return AllocatorType::owns(block.getPtr());
 		}
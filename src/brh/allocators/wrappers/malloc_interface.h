@@ -0,0 +1,218 @@
+#ifndef BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_WRAPPERS_MALLOC_INTERFACE_H
+#define BRH_CPP_ALLOCATORS_SRC_BRH_ALLOCATORS_WRAPPERS_MALLOC_INTERFACE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include <supports/round_up_to_multiple.h>
+
+#include "../common/common_types.h"
+#include "../blocks/block.h"
+#include "../traits/traits.h"
+
+namespace brh {
+	namespace allocators {
+
+/// The C allocation functions on top of an allocator.
+///
+/// Deallocation here needs the block size, which free doesn't pass.
+/// Every block therefore starts with a header right before the returned
+/// pointer that holds the size of the block and how far into the block
+/// the pointer lies. Blocks of the allocator must be aligned to
+/// alignof(std::max_align_t).
+///
+/// Failures set errno like the C functions do. The allocator must not
+/// call malloc itself if the functions replace the ones of the C library.
+template <class t_Allocator>
+class MallocInterface {
+	public:
+		using Allocator = t_Allocator;
+
+		static constexpr SizeType defaultAlignment {alignof(std::max_align_t)};
+
+		MallocInterface(Allocator & allocator) : allocator_ (allocator) {}
+
+		void * malloc(SizeType size) {
+			return allocateAligned(size, defaultAlignment);
+		}
+
+		void free(void * ptr) {
+			if (ptr != nullptr)
+				allocator_.deallocate(getBlock(ptr));
+		}
+
+		void * calloc(SizeType count, SizeType size) {
+			if (size != 0 && count > maxSize / size) {
+				errno = ENOMEM;
+				return nullptr;
+			}
+
+			auto const ptr = malloc(count * size);
+
+			if (ptr != nullptr)
+				std::memset(ptr, 0, count * size);
+
+			return ptr;
+		}
+
+		/// Resizes through the allocator when the pointer lies right after
+		/// the header, otherwise copies to a new block.
+		void * realloc(void * ptr, SizeType size) {
+			if (ptr == nullptr)
+				return malloc(size);
+
+			if (size == 0) {
+				free(ptr);
+				return nullptr;
+			}
+
+			auto const header = getHeader(ptr);
+
+			if (header.offset == headerSize && size <= maxSize - headerSize) {
+				auto block = getBlock(ptr);
+
+				if (traits::reallocate(allocator_, block, size + headerSize)) {
+					setHeader(block, headerSize);
+					return block.getCharPtr() + headerSize;
+				}
+			}
+
+			auto const newPtr = malloc(size);
+
+			if (newPtr == nullptr)
+				return nullptr;
+
+			auto const usable = header.size - header.offset;
+
+			std::memcpy(newPtr, ptr, usable < size ? usable : size);
+			free(ptr);
+
+			return newPtr;
+		}
+
+		/// Like realloc, but fails instead of wrapping around when
+		/// count * size overflows.
+		void * reallocArray(void * ptr, SizeType count, SizeType size) {
+			if (size != 0 && count > maxSize / size) {
+				errno = ENOMEM;
+				return nullptr;
+			}
+
+			return realloc(ptr, count * size);
+		}
+
+		/// @return nullptr if the alignment isn't a power of 2.
+		void * allocateAligned(SizeType size, SizeType alignment) {
+			if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+				errno = EINVAL;
+				return nullptr;
+			}
+
+			if (alignment < defaultAlignment)
+				alignment = defaultAlignment;
+
+			// Larger alignments are reached by skipping ahead in a
+			// larger block.
+			auto const padding = headerSize + (alignment - defaultAlignment);
+
+			if (size > maxSize - padding) {
+				errno = ENOMEM;
+				return nullptr;
+			}
+
+			auto const block = allocator_.allocate(size + padding);
+
+			if (block.isNull()) {
+				errno = ENOMEM;
+				return nullptr;
+			}
+
+			auto const address = reinterpret_cast<std::uintptr_t>(
+				block.getCharPtr() + headerSize
+			);
+
+			auto const offset = headerSize + static_cast<SizeType>(
+				supports::roundUpToMultiple(
+					address, static_cast<std::uintptr_t>(alignment)
+				) - address
+			);
+
+			setHeader(block, offset);
+			return block.getCharPtr() + offset;
+		}
+
+		/// Like posix_memalign, returns an error number instead of setting
+		/// errno.
+		int allocateAligned(void ** out, SizeType size, SizeType alignment) {
+			if (alignment < sizeof(void *))
+				return EINVAL;
+
+			auto const savedErrno = errno;
+			auto const ptr = allocateAligned(size, alignment);
+
+			if (ptr == nullptr) {
+				auto const error = errno;
+				errno = savedErrno;
+				return error;
+			}
+
+			*out = ptr;
+			return 0;
+		}
+
+		SizeType getUsableSize(void * ptr) const {
+			if (ptr == nullptr)
+				return 0;
+
+			auto const header = getHeader(ptr);
+
+			return header.size - header.offset;
+		}
+
+		/// The whole block of the allocator that contains the pointer.
+		RawBlock getBlock(void * ptr) const {
+			auto const header = getHeader(ptr);
+
+			return {static_cast<char *>(ptr) - header.offset, header.size};
+		}
+
+
+	private:
+		struct Header {
+			SizeType size;
+			SizeType offset;
+		};
+
+		static constexpr SizeType headerSize {
+			supports::roundUpToMultiple(sizeof(Header), defaultAlignment)
+		};
+
+		static constexpr SizeType maxSize {
+			std::numeric_limits<SizeType>::max()
+		};
+
+		static Header getHeader(void * ptr) {
+			Header header;
+			std::memcpy(&header, static_cast<char *>(ptr) - sizeof(Header),
+			            sizeof(Header));
+
+			return header;
+		}
+
+		static void setHeader(RawBlock block, SizeType offset) {
+			Header const header {block.getSize(), offset};
+			std::memcpy(block.getCharPtr() + offset - sizeof(Header), &header,
+			            sizeof(Header));
+		}
+
+		Allocator & allocator_;
+};
+
+
+	}
+}
+
+#endif
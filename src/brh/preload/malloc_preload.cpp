@@ -0,0 +1,166 @@
+/// Replaces the allocation functions of the C library when loaded with
+/// LD_PRELOAD, for example
+/// `LD_PRELOAD=libbrh_malloc_preload.so ./program`.
+///
+/// The allocator is ThreadCachingAllocator with MmapAllocator for large
+/// sizes. Another composition can be used by pointing
+/// BRH_CPP_ALLOCATORS_PRELOAD_ALLOCATOR_HEADER at a header that defines
+/// brh::allocators::preload::Allocator. It must be default constructible
+/// and must not call malloc. If it has lockAll and unlockAll, they are
+/// called around fork so that the child doesn't inherit held locks.
+
+#include <cerrno>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <supports/round_up_to_multiple.h>
+
+#include <allocators/traits/traits.h>
+#include <allocators/wrappers/malloc_interface.h>
+
+#ifdef BRH_CPP_ALLOCATORS_PRELOAD_ALLOCATOR_HEADER
+#include BRH_CPP_ALLOCATORS_PRELOAD_ALLOCATOR_HEADER
+#else
+#include <allocators/thread_caching_allocator.h>
+#include <allocators/mmap_allocator.h>
+
+namespace brh {
+	namespace allocators {
+		namespace preload {
+
+using Allocator = ThreadCachingAllocator::Allocator<
+	ThreadCachingAllocator::TemplatedPolicy<
+		16, 5, 64 * 1024, 64, 256, 16 * 1024, 32 * 1024, MmapAllocator
+	>
+>;
+
+		} // preload
+	}
+}
+#endif
+
+namespace {
+
+using brh::allocators::preload::Allocator;
+using Interface = brh::allocators::MallocInterface<Allocator>;
+
+/// The allocator is never destroyed, blocks are still freed after static
+/// destructors ran.
+Allocator & getAllocator() {
+	static typename std::aligned_storage<
+		sizeof(Allocator), alignof(Allocator)>::type storage;
+
+	static auto const allocator = new (&storage) Allocator();
+
+	return *allocator;
+}
+
+Interface & getInterface() {
+	static Interface interface {getAllocator()};
+
+	return interface;
+}
+
+
+template <class Type>
+using LockAllOperation = decltype(std::declval<Type &>().lockAll());
+
+using HasLockAll =
+	brh::allocators::traits::IsDetected<LockAllOperation, Allocator>;
+
+template <class Type>
+void lockAll(std::true_type, Type & allocator) { allocator.lockAll(); }
+
+template <class Type>
+void lockAll(std::false_type, Type &) {}
+
+template <class Type>
+void unlockAll(std::true_type, Type & allocator) { allocator.unlockAll(); }
+
+template <class Type>
+void unlockAll(std::false_type, Type &) {}
+
+/// Like the C library, the locks are taken before fork and released
+/// after it in both processes. Otherwise a child forked while another
+/// thread held one would block on it forever.
+struct ForkHandlers {
+	ForkHandlers() {
+		pthread_atfork(
+			[] { lockAll(HasLockAll(), getAllocator()); },
+			[] { unlockAll(HasLockAll(), getAllocator()); },
+			[] { unlockAll(HasLockAll(), getAllocator()); }
+		);
+	}
+};
+
+/// Registered when the library is loaded, registering may allocate.
+ForkHandlers const forkHandlers;
+
+} // anonymous
+
+
+extern "C" {
+
+void * malloc(std::size_t size) noexcept {
+	return getInterface().malloc(size);
+}
+
+void free(void * ptr) noexcept {
+	getInterface().free(ptr);
+}
+
+void * calloc(std::size_t count, std::size_t size) noexcept {
+	return getInterface().calloc(count, size);
+}
+
+void * realloc(void * ptr, std::size_t size) noexcept {
+	return getInterface().realloc(ptr, size);
+}
+
+void * reallocarray(void * ptr, std::size_t count, std::size_t size) noexcept {
+	return getInterface().reallocArray(ptr, count, size);
+}
+
+int posix_memalign(void ** out, std::size_t alignment, std::size_t size) noexcept {
+	return getInterface().allocateAligned(out, size, alignment);
+}
+
+void * aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+	return getInterface().allocateAligned(size, alignment);
+}
+
+void * memalign(std::size_t alignment, std::size_t size) noexcept {
+	return getInterface().allocateAligned(size, alignment);
+}
+
+void * valloc(std::size_t size) noexcept {
+	return getInterface().allocateAligned(
+		size, static_cast<std::size_t>(sysconf(_SC_PAGESIZE))
+	);
+}
+
+/// Rounds the size up to whole pages, at least one.
+void * pvalloc(std::size_t size) noexcept {
+	auto const pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+	if (size > ~std::size_t {0} - pageSize) {
+		errno = ENOMEM;
+		return nullptr;
+	}
+
+	return getInterface().allocateAligned(
+		size == 0 ? pageSize : brh::supports::roundUpToMultiple(size, pageSize),
+		pageSize
+	);
+}
+
+std::size_t malloc_usable_size(void * ptr) noexcept {
+	return getInterface().getUsableSize(ptr);
+}
+
+} // extern "C"
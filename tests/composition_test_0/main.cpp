@@ -0,0 +1,129 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+
+#include <allocators/composition.h>
+
+using namespace brh::allocators;
+using namespace composition;
+
+using FreeList = BlockAllocatorRegularInterface<
+	FullFreeList::Templated<std::array, 16, 64>
+>;
+
+using Bitmap = BitmappedBlock::Templated<std::array, 32, 256>;
+
+
+using Full = Compose<
+	Segregate<16,
+		Use<FreeList>,
+		Fallback<Use<Bitmap>, Use<MallocAllocator> >
+	>
+>;
+
+static_assert(std::is_same<
+	Full,
+	Segregator::Templated<
+		FreeList, FallbackAllocator<Bitmap, MallocAllocator>, 16
+	>
+>::value, "Nothing should be folded");
+
+
+// No size above 16 can be requested, so only the free list is reachable.
+using Folded = Compose<
+	Segregate<64,
+		Segregate<16, Use<FreeList>, Use<Bitmap> >,
+		Use<MallocAllocator>
+	>,
+	Requirements<16>
+>;
+
+static_assert(std::is_same<Folded, FreeList>::value,
+              "Unreachable layers should be folded");
+
+
+// Sizes above the bitmap's storage never reach it.
+using FoldedFallback = Compose<
+	Segregate<16,
+		Use<FreeList>,
+		Segregate<1024 * 1024,
+			Fallback<Use<Bitmap>, Use<MmapAllocator> >,
+			Fallback<Use<Bitmap>, Use<MallocAllocator> >
+		>
+	>
+>;
+
+static_assert(std::is_same<
+	FoldedFallback,
+	Segregator::Templated<
+		FreeList,
+		Segregator::Templated<
+			FallbackAllocator<Bitmap, MmapAllocator>,
+			MallocAllocator, 1024 * 1024
+		>, 16
+	>
+>::value, "The unreachable primary should be folded");
+
+
+// malloc may return more than was asked for, so it can't be the small side
+// of a Segregate. Segregate<16, Use<MallocAllocator>, ...> fails to compile.
+static_assert(Contract<MallocAllocator>::calcBlockSize(10) > 16,
+              "malloc's block sizes should be unknown");
+
+// Unless the threshold is unbounded, then the large side is unreachable.
+using MallocOnly = Compose<
+	Segregate<unbounded, Use<MallocAllocator>, Use<MmapAllocator> >
+>;
+
+static_assert(std::is_same<MallocOnly, MallocAllocator>::value,
+              "An unbounded threshold leaves only the small side");
+
+
+/// Every block must come back to the child that allocated it.
+template <class Allocator>
+void allocateAndFree(Allocator & allocator,
+                     std::initializer_list<SizeType> sizes) {
+	std::vector<RawBlock> blocks;
+
+	for (auto size : sizes) {
+		auto block = allocator.allocate(size);
+		assert(!block.isNull() && block.getSize() >= size);
+
+		std::memset(block.getPtr(), 0xCD, size);
+		blocks.push_back(block);
+	}
+
+	for (auto block : blocks)
+		allocator.deallocate(block);
+}
+
+
+int main(int argc, char* argv[])
+{
+	Full allocator;
+
+	auto small  = allocator.allocate(8);
+	auto medium = allocator.allocate(100);
+	auto large  = allocator.allocate(100000);
+
+	std::cout << small.getPtr()  << ' ' << small.getSize()  << '\n'
+	          << medium.getPtr() << ' ' << medium.getSize() << '\n'
+	          << large.getPtr()  << ' ' << large.getSize()  << '\n';
+
+	allocator.deallocate(large);
+	allocator.deallocate(medium);
+	allocator.deallocate(small);
+
+	FoldedFallback folded;
+	allocateAndFree(folded, {1, 10, 16, 17, 24, 100, 8192, 8193,
+	                         1024 * 1024, 1024 * 1024 + 1});
+
+	MallocOnly mallocOnly;
+	allocateAndFree(mallocOnly, {1, 10, 24, 100000});
+
+	return 0;
+}
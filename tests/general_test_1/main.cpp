@@ -0,0 +1,77 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/mman.h>
+
+#include <allocators/mmap_allocator.h>
+
+using namespace brh::allocators;
+
+/// Maps the page at ptr so that blocks before it can't grow in place.
+void * mapGuard(void * ptr) {
+	auto const guard = mmap(ptr, MmapAllocator::getPageSize(), PROT_NONE,
+	                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+
+	assert(guard == ptr);
+	return guard;
+}
+
+int main(int argc, char* argv[])
+{
+	MmapAllocator allocator;
+
+	auto const pageSize = MmapAllocator::getPageSize();
+
+	// Alignments above the page size map extra pages and trim them.
+	for (SizeType alignment {pageSize * 2}; alignment <= pageSize * 64;
+	     alignment *= 2) {
+		auto block = allocator.allocateAligned(pageSize + 1, alignment);
+
+		assert(!block.isNull());
+		assert(reinterpret_cast<std::uintptr_t>(block.getPtr()) % alignment == 0);
+		assert(block.getSize() == pageSize * 2);
+
+		std::memset(block.getPtr(), 0xAB, block.getSize());
+		allocator.deallocate(block);
+	}
+
+	// Shrinking leaves the page after the block unmapped, so it grows back
+	// in place.
+	auto block = allocator.allocate(pageSize * 3);
+	assert(allocator.reallocate(block, pageSize));
+
+	auto const ptr = block.getPtr();
+	std::memset(ptr, 0x5A, pageSize);
+
+	assert(allocator.expand(block, pageSize * 2));
+	assert(block.getPtr() == ptr);
+	assert(block.getSize() == pageSize * 3);
+	assert(static_cast<unsigned char *>(block.getPtr())[pageSize - 1] == 0x5A);
+
+	// With the next page taken, expand fails and reallocate moves.
+	assert(allocator.reallocate(block, pageSize));
+
+	auto const guard = mapGuard(block.getCharPtr() + pageSize);
+
+	assert(!allocator.expand(block, pageSize));
+	assert(block.getPtr() == ptr && block.getSize() == pageSize);
+
+	for (SizeType i {0}; i < pageSize; ++i)
+		block.getCharPtr()[i] = static_cast<char>(i);
+
+	assert(allocator.reallocate(block, pageSize * 16));
+	assert(block.getPtr() != ptr);
+	assert(block.getSize() == pageSize * 16);
+
+	for (SizeType i {0}; i < pageSize; ++i)
+		assert(block.getCharPtr()[i] == static_cast<char>(i));
+
+	allocator.deallocate(block);
+	munmap(guard, pageSize);
+
+	std::cout << "Passed\n";
+
+	return 0;
+}
@@ -0,0 +1,149 @@
+#include <iostream>
+#include <array>
+#include <cassert>
+#include <vector>
+
+#include <allocators/compacting_allocator.h>
+
+using namespace brh::allocators;
+
+using Allocator = CompactingAllocator::Templated<std::array, 64 * 1024>;
+using Handle    = CompactingAllocator::Handle;
+using Budget    = CompactingAllocator::Budget;
+
+struct Live {
+	Handle   handle;
+	SizeType size;
+	char     seed;
+};
+
+void fill(Allocator & allocator, Live const & live) {
+	auto const block = allocator.getBlock(live.handle);
+
+	assert(block.getSize() >= live.size);
+
+	for (SizeType i {0}; i < live.size; ++i)
+		block.getCharPtr()[i] = static_cast<char>(live.seed + i);
+}
+
+void check(Allocator & allocator, Live const & live) {
+	auto const block = allocator.getBlock(live.handle);
+
+	assert(block.getSize() >= live.size);
+
+	for (SizeType i {0}; i < live.size; ++i)
+		assert(block.getCharPtr()[i] == static_cast<char>(live.seed + i));
+}
+
+Live allocate(Allocator & allocator, SizeType size, char seed) {
+	Live live {allocator.allocate(size), size, seed};
+
+	assert(!live.handle.isNull());
+	fill(allocator, live);
+
+	return live;
+}
+
+SizeType calcOccupied(std::vector<Live> const & lives) {
+	SizeType occupied {0};
+
+	for (auto const & live : lives)
+		occupied += Allocator::calcRequiredSize(live.size);
+
+	return occupied;
+}
+
+static Allocator allocator;
+
+int main(int argc, char* argv[])
+{
+	std::vector<Live> lives;
+
+	for (SizeType i {0}; i < 200; ++i)
+		lives.push_back(
+			allocate(allocator, 16 + (i * 37) % 200, static_cast<char>(i))
+		);
+
+	// Every third block leaves a hole.
+	std::vector<Live> kept;
+
+	for (SizeType i {0}; i < lives.size(); ++i) {
+		if (i % 3 == 0)
+			allocator.deallocate(lives[i].handle);
+		else
+			kept.push_back(lives[i]);
+	}
+
+	lives = kept;
+
+	assert(allocator.calcFragmented() > 0);
+	assert(allocator.calcOccupied() == calcOccupied(lives));
+
+	// A small budget splits the pass over many calls. Blocks are freed,
+	// resized and allocated while it runs.
+	SizeType calls {0};
+
+	while (!allocator.compact(Budget::makeBytes(256))) {
+		++calls;
+
+		if (calls == 3) {
+			allocator.deallocate(lives.front().handle);
+			allocator.deallocate(lives.back().handle);
+
+			lives.erase(lives.begin());
+			lives.pop_back();
+		}
+
+		if (calls == 5) {
+			// Moves the block to the top, ahead of the pass.
+			auto & grown = lives[lives.size() / 2];
+
+			assert(allocator.reallocate(grown.handle, grown.size + 300));
+			check(allocator, grown);
+
+			grown.size += 300;
+			fill(allocator, grown);
+
+			// It is the top block now and shrinks in place.
+			auto const ptr = allocator.getBlock(grown.handle).getPtr();
+
+			assert(allocator.reallocate(grown.handle, 40));
+			assert(allocator.getBlock(grown.handle).getPtr() == ptr);
+
+			grown.size = 40;
+			check(allocator, grown);
+
+			lives.push_back(allocate(allocator, 500, 'x'));
+		}
+
+		for (auto const & live : lives)
+			check(allocator, live);
+
+		assert(calls < 10000);
+	}
+
+	assert(calls > 5);
+
+	for (auto const & live : lives)
+		check(allocator, live);
+
+	assert(allocator.calcFragmented() == 0);
+	assert(allocator.calcOccupied() == calcOccupied(lives));
+
+	// Compacted space is reused by new blocks.
+	auto const rest = allocator.calcUnoccupied() - Allocator::calcRequiredSize(0);
+	lives.push_back(allocate(allocator, rest, 'y'));
+
+	for (auto const & live : lives)
+		check(allocator, live);
+
+	for (auto const & live : lives)
+		allocator.deallocate(live.handle);
+
+	assert(allocator.isEmpty());
+	assert(allocator.compact());
+
+	std::cout << "Passed" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+#include <allocators/object_pool.h>
+
+using namespace brh::allocators;
+
+/// Counts the live objects, constructors throw once the countdown hits 0.
+struct Thrower {
+	static int live;
+	static int countdown;
+
+	explicit Thrower(int value) : value {value} {
+		if (countdown >= 0 && countdown-- == 0)
+			throw std::runtime_error("Thrower");
+
+		++live;
+	}
+
+	~Thrower() {
+		--live;
+	}
+
+	int value;
+};
+
+int Thrower::live      {0};
+int Thrower::countdown {-1};
+
+using Pool = ObjectPool::Templated<Thrower, std::array, 256>;
+
+/// Every block can be taken again.
+void checkAllFree(Pool & pool) {
+	std::vector<Thrower *> objects (pool.getCapacity());
+
+	assert(pool.constructBulk(objects.data(), objects.size(), 7) ==
+	       pool.getCapacity());
+	assert(pool.construct(8) == nullptr);
+	assert(Thrower::live == static_cast<int>(pool.getCapacity()));
+
+	pool.destroyBulk(objects.data(), objects.size());
+	assert(Thrower::live == 0);
+}
+
+int main(int argc, char* argv[])
+{
+	{
+		Pool pool;
+
+		// A throwing constructor gives its block back.
+		for (int i {0}; i < 10; ++i) {
+			Thrower::countdown = 0;
+
+			try {
+				pool.construct(1);
+				assert(false);
+			}
+			catch (std::runtime_error const &) {}
+		}
+
+		Thrower::countdown = -1;
+		checkAllFree(pool);
+
+		// Throwing in the second batch destroys the first batch and the
+		// start of the second, and frees the rest of the second.
+		std::vector<Thrower *> objects (200);
+		Thrower::countdown = 100;
+
+		try {
+			pool.constructBulk(objects.data(), objects.size(), 2);
+			assert(false);
+		}
+		catch (std::runtime_error const &) {}
+
+		Thrower::countdown = -1;
+		assert(Thrower::live == 0);
+		checkAllFree(pool);
+
+		// Objects that survive a failed call are unaffected.
+		auto const kept = pool.construct(3);
+		Thrower::countdown = 0;
+
+		try {
+			pool.constructBulk(objects.data(), 10, 4);
+			assert(false);
+		}
+		catch (std::runtime_error const &) {}
+
+		Thrower::countdown = -1;
+		assert(Thrower::live == 1 && kept->value == 3);
+		pool.destroy(kept);
+
+		checkAllFree(pool);
+	}
+
+	assert(Thrower::live == 0);
+
+	std::cout << "Passed" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <allocators/reserved_stack_allocator.h>
+
+using namespace brh::allocators;
+
+using Allocator = ReservedStackAllocator::Allocator;
+using Policy    = ReservedStackAllocator::Policy;
+
+/// Bytes of the range that are mapped readable and writable, from
+/// /proc/self/maps.
+SizeType calcCommitted(char const * begin, SizeType size) {
+	auto const first = reinterpret_cast<std::uintptr_t>(begin);
+	auto const last  = first + size;
+
+	std::ifstream maps {"/proc/self/maps"};
+	std::string   line;
+	SizeType      committed {0};
+
+	while (std::getline(maps, line)) {
+		std::istringstream stream {line};
+		std::uintptr_t     start, end;
+		char               dash;
+		std::string        permissions;
+
+		stream >> std::hex >> start >> dash >> end >> permissions;
+
+		if (permissions.compare(0, 2, "rw") != 0)
+			continue;
+
+		auto const from = (start > first ? start : first);
+		auto const to   = (end   < last  ? end   : last);
+
+		if (from < to)
+			committed += to - from;
+	}
+
+	return committed;
+}
+
+SizeType roundUpToPage(SizeType size) {
+	auto const pageSize = MmapAllocator::getPageSize();
+
+	return (size + pageSize - 1) / pageSize * pageSize;
+}
+
+void fill(RawBlock block, SizeType from, char value) {
+	std::memset(block.getCharPtr() + from, value, block.getSize() - from);
+}
+
+bool check(RawBlock block, SizeType size, char value) {
+	for (SizeType i {0}; i < size; ++i) {
+		if (block.getCharPtr()[i] != value)
+			return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	SizeType const step     {64 * 1024};
+	SizeType const retained {128 * 1024};
+
+	Allocator stack {Policy(64 * 1024 * 1024, retained, step)};
+
+	auto const size = stack.getStorageSize();
+
+	// The first allocation commits a step, not the whole reservation.
+	auto first = stack.allocate(100);
+	auto const begin = first.getCharPtr();
+
+	assert(calcCommitted(begin, size) == step);
+
+	auto top = stack.allocate(1000);
+	fill(first, 0, 'f');
+	fill(top, 0, 't');
+
+	// The top block grows in place past the committed end.
+	assert(stack.expand(top, step));
+	assert(calcCommitted(begin, size) == 2 * step);
+	assert(check(top, 1000, 't'));
+	fill(top, 1000, 'u');
+
+	auto const ptr = top.getPtr();
+
+	assert(stack.reallocate(top, 5 * step + 1));
+	assert(top.getPtr() == ptr && top.getSize() == 5 * step + 1);
+	assert(calcCommitted(begin, size) == roundUpToPage(100 + 5 * step + 1));
+	assert(check(top, 1000, 't'));
+	fill(top, 1000 + step, 'v');
+
+	// Blocks below the top stay as they are.
+	assert(!stack.expand(first, 1));
+	assert(!stack.reallocate(first, 200));
+	assert(check(first, 100, 'f'));
+
+	// Shrinking keeps the memory committed.
+	assert(stack.reallocate(top, 10));
+	assert(calcCommitted(begin, size) == roundUpToPage(100 + 5 * step + 1));
+
+	// The reservation bounds the stack.
+	assert(stack.allocate(size).isNull());
+	assert(!stack.expand(top, size));
+
+	// Resetting gives back everything above the retained size.
+	stack.deallocateAll();
+	assert(stack.isEmpty());
+	assert(calcCommitted(begin, size) == retained);
+
+	// Pages are committed again on demand.
+	auto big = stack.allocate(retained + 1);
+	assert(big.getCharPtr() == begin);
+	fill(big, 0, 'b');
+	assert(calcCommitted(begin, size) == roundUpToPage(retained + step));
+
+	std::cout << "Passed" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#include <allocators/cascading_allocator.h>
+#include <allocators/malloc_allocator.h>
+#include <allocators/stack_allocator.h>
+
+using namespace brh::allocators;
+
+using Child     = StackAllocator::Templated<std::array, 1024>;
+using Allocator = CascadingAllocator::Templated<Child, MallocAllocator, 1>;
+
+RawBlock allocate(Allocator & allocator, SizeType size, char value) {
+	auto const block = allocator.allocate(size);
+
+	assert(!block.isNull());
+	std::memset(block.getPtr(), value, block.getSize());
+
+	return block;
+}
+
+bool check(RawBlock block, SizeType size, char value) {
+	for (SizeType i {0}; i < size; ++i) {
+		if (block.getCharPtr()[i] != value)
+			return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	Allocator allocator;
+
+	// Three blocks fill a child, another child is made for every three.
+	std::vector<RawBlock> blocks;
+
+	for (SizeType i {0}; i < 12; ++i)
+		blocks.push_back(allocate(allocator, 300, static_cast<char>(i)));
+
+	assert(allocator.getChildCount() == 4);
+	assert(!allocator.isEmpty());
+
+	for (SizeType i {0}; i < blocks.size(); ++i)
+		assert(allocator.owns(blocks[i]));
+
+	// Too large for any child.
+	assert(allocator.allocate(2000).isNull());
+	assert(allocator.getChildCount() == 4);
+
+	// Blocks of children other than the last one used are found by
+	// address. Freed bottom first, the stacks are left where they were.
+	for (SizeType i {0}; i < 3; ++i)
+		allocator.deallocate(blocks[i]);
+
+	assert(allocator.getChildCount() == 4);
+
+	// A second empty child exceeds the spare count and is released.
+	for (SizeType i {3}; i < 6; ++i)
+		allocator.deallocate(blocks[i]);
+
+	assert(allocator.getChildCount() == 3);
+
+	// The spare was reset, so it takes three blocks again.
+	std::vector<RawBlock> refill;
+
+	for (SizeType i {0}; i < 3; ++i)
+		refill.push_back(allocate(allocator, 300, 'r'));
+
+	assert(allocator.getChildCount() == 3);
+
+	// A block below the top of its child can't grow in place and moves.
+	auto & moved = blocks[9];
+	auto const oldPtr = moved.getPtr();
+
+	assert(allocator.reallocate(moved, 900));
+	assert(moved.getPtr() != oldPtr && moved.getSize() == 900);
+	assert(check(moved, 300, 9));
+	assert(allocator.getChildCount() == 4);
+
+	// The top block grows in place.
+	auto & top = refill.back();
+	auto const topPtr = top.getPtr();
+
+	assert(allocator.reallocate(top, 400));
+	assert(top.getPtr() == topPtr);
+	assert(check(top, 300, 'r'));
+
+	// Blocks from elsewhere are left alone.
+	MallocAllocator malloc;
+	auto const foreign = malloc.allocate(64);
+
+	assert(!allocator.owns(foreign));
+	allocator.deallocate(foreign);
+	malloc.deallocate(foreign);
+
+	for (SizeType i {6}; i < blocks.size(); ++i)
+		assert(check(blocks[i], 300, static_cast<char>(i)));
+
+	for (SizeType i {6}; i < blocks.size(); ++i)
+		allocator.deallocate(blocks[i]);
+
+	for (auto const & block : refill)
+		allocator.deallocate(block);
+
+	assert(allocator.isEmpty());
+	assert(allocator.getChildCount() == 1);
+
+	std::cout << "Passed" << std::endl;
+
+	return 0;
+}
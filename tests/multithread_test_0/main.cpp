@@ -1,8 +1,6 @@
 #include <iostream>
 #include <array>
 
-#define BRH_CPP_ALLOCATORS_MULTITHREADED
-
 #include <allocators/bitmapped_block.h>
 
 using namespace brh::allocators;
@@ -10,7 +8,9 @@ using namespace brh::allocators;
 using Type = long;
 
 using AllocatorCore = BitmappedBlock::Templated<
-	std::array, sizeof(Type), 16, sizeof(Type)
+	std::array, sizeof(Type), 16, sizeof(Type),
+	BitmappedBlock::NextFit, BitmappedBlock::NoSizeRecovery,
+	BitmappedBlock::MutexLock
 >;
 
 using Allocator = AllocatorWrapper<AllocatorCore>;
@@ -14,9 +14,12 @@
 #include <allocators/segregator.h>
 #include <allocators/fallback_allocator.h>
 #include <allocators/affix_allocator.h>
+#include <allocators/malloc_allocator.h>
+#include <allocators/thread_caching_allocator.h>
 
 #include "test_base.h"
 #include "random_size_allocation_test.h"
+#include "multithreaded_test.h"
 #include "get_time.h"
 #include "test_factory.h"
 
@@ -459,6 +462,18 @@ int main(int argc, char* argv[])
 		});*/
 
 		runTestsOld();
+
+		using MallocTestType = RandomSizeAllocationTest<
+			MallocAllocator, AllocatorReturnTypeSimple>;
+
+		using ThreadCachingTestType = RandomSizeAllocationTest<
+			SingletonReference<ThreadCachingAllocator::Singleton>,
+			AllocatorReturnTypeSimple>;
+
+		std::cout << '\n';
+		compareMultithreaded<MallocTestType, ThreadCachingTestType>(
+			"malloc", "Thread caching", 1'000, 1'000
+		);
 	}
 	catch (std::exception & e) {
 		std::cout << "Main caught: " << e.what() << '\n';
@@ -0,0 +1,102 @@
+#ifndef BRH_CPP_ALLOCATORS_TESTS_PERFORMANCE_TEST_0_MULTITHREADED_TEST_H
+#define BRH_CPP_ALLOCATORS_TESTS_PERFORMANCE_TEST_0_MULTITHREADED_TEST_H
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <string>
+
+#include <allocators/blocks/block.h>
+
+#include "random_size_allocation_test.h"
+#include "get_time.h"
+
+namespace brh {
+	namespace allocators {
+		namespace tests {
+
+/// Lets every thread's test share the process wide instance.
+template <class Singleton>
+class SingletonReference
+{
+	public:
+		RawBlock allocate(std::size_t size) {
+			return Singleton::get().allocate(size);
+		}
+
+		void deallocate(RawBlock block) {
+			Singleton::get().deallocate(block);
+		}
+};
+
+
+/// Runs a copy of the test on every thread at once.
+///
+/// @return The average time that a thread spends in construct and
+///         destruct per iteration.
+template <class TestType>
+double runMultithreaded(std::size_t threadCount,
+                        std::size_t elementCount,
+                        std::size_t iterations) {
+	std::vector<std::thread>    threads;
+	std::vector<std::ptrdiff_t> times (threadCount, 0);
+	std::atomic<bool>           start {false};
+
+	for (std::size_t i {0}; i < threadCount; ++i) {
+		threads.emplace_back([&, i]() {
+			TestType test {"", elementCount};
+
+			while (!start.load()) {}
+
+			for (std::size_t j {0}; j < iterations; ++j) {
+				test.initialize();
+
+				auto begin = getTime();
+				test.construct();
+				test.destruct();
+				times[i] += getTime() - begin;
+
+				test.restart();
+			}
+		});
+	}
+
+	start.store(true);
+
+	for (auto & thread : threads)
+		thread.join();
+
+	double total {0};
+	for (auto time : times)
+		total += time;
+
+	return total / (threadCount * iterations);
+}
+
+template <class FirstTest, class SecondTest>
+void compareMultithreaded(std::string const & firstName,
+                          std::string const & secondName,
+                          std::size_t         elementCount,
+                          std::size_t         iterations) {
+	std::cout << std::left << std::setw(10) << "Threads" << std::right <<
+		std::setw(16) << firstName <<
+		std::setw(16) << secondName << "   (us per iteration)\n";
+
+	for (std::size_t threads : {1, 2, 4, 8, 16}) {
+		std::cout << std::left << std::setw(10) << threads << std::right <<
+			std::setw(16) <<
+				runMultithreaded<FirstTest>(threads, elementCount, iterations) <<
+			std::setw(16) <<
+				runMultithreaded<SecondTest>(threads, elementCount, iterations) <<
+			'\n';
+	}
+}
+
+
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,246 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <string>
+#include <cmath>
+
+#include <allocators/bitmapped_block.h>
+
+#include "../performance_test_0/get_time.h"
+
+using namespace brh::allocators;
+
+template <class T>
+using VectorSingle = std::vector<T>;
+
+
+/// One step of the trace, either an allocation into a slot or the
+/// deallocation of a slot.
+struct Instruction {
+	bool        allocate;
+	std::size_t slot;
+	std::size_t size;
+};
+
+/// Mixed sizes with a long tail, and frees in random order so that the
+/// arena splinters.
+std::vector<Instruction> makeTrace(std::size_t length, std::size_t maxLive) {
+	std::mt19937 randomEngine {0};
+	std::normal_distribution<> distribution {0, 256};
+
+	std::vector<Instruction> trace;
+	std::vector<std::size_t> live;
+	std::vector<std::size_t> freeSlots;
+	std::size_t slotCount {0};
+
+	trace.reserve(length);
+
+	for (std::size_t i {0}; i < length; ++i) {
+		bool allocate {
+			live.empty() ||
+			(live.size() < maxLive && randomEngine() % 3 != 0)
+		};
+
+		if (allocate) {
+			std::size_t slot;
+
+			if (freeSlots.empty()) {
+				slot = slotCount++;
+			}
+			else {
+				slot = freeSlots.back();
+				freeSlots.pop_back();
+			}
+
+			auto size = static_cast<std::size_t>(
+				std::abs(std::round(distribution(randomEngine)))
+			) + 1;
+
+			trace.push_back({true, slot, size});
+			live.push_back(slot);
+		}
+
+		else {
+			auto index = randomEngine() % live.size();
+			auto slot  = live[index];
+
+			live[index] = live.back();
+			live.pop_back();
+			freeSlots.push_back(slot);
+
+			trace.push_back({false, slot, 0});
+		}
+	}
+
+	return trace;
+}
+
+
+template <class Placement>
+void runTrace(std::string const & name,
+              std::vector<Instruction> const & trace,
+              std::size_t iterations) {
+	using Allocator = BitmappedBlock::Runtime<VectorSingle, 16, Placement>;
+
+	constexpr SizeType blockSize  {16};
+	constexpr SizeType blockCount {1024 * 64};
+
+	std::size_t slotCount {0};
+	for (auto const & instruction : trace) {
+		if (instruction.slot >= slotCount)
+			slotCount = instruction.slot + 1;
+	}
+
+	std::ptrdiff_t totalTime {0};
+	std::size_t    failures  {0};
+
+	BitmappedBlock::FragmentationSnapshot snapshot {};
+
+	for (std::size_t iteration {0}; iteration < iterations; ++iteration) {
+		Allocator allocator {{blockSize, blockCount}};
+		std::vector<RawBlock> slots (slotCount, RawBlock::makeNullBlock());
+
+		failures = 0;
+
+		auto start = brh::getTime();
+
+		for (auto const & instruction : trace) {
+			auto & block = slots[instruction.slot];
+
+			if (instruction.allocate) {
+				block = allocator.allocate(instruction.size);
+
+				if (block.isNull())
+					++failures;
+			}
+			else {
+				allocator.deallocate(block);
+				block = RawBlock::makeNullBlock();
+			}
+		}
+
+		totalTime += brh::getTime() - start;
+
+		// Only the last pass is sampled so that the timing isn't affected.
+		if (iteration + 1 == iterations)
+			snapshot = allocator.takeSnapshot();
+	}
+
+	std::cout << std::left << std::setw(18) << name << std::right <<
+		std::setw(12) << totalTime / static_cast<std::ptrdiff_t>(iterations) <<
+		std::setw(10) << failures <<
+		std::setw(12) << std::setprecision(3) <<
+		snapshot.calcExternalFragmentation() <<
+		std::setw(10) << snapshot.freeRuns <<
+		std::setw(10) << snapshot.largestFreeRun <<
+		std::setw(10) << snapshot.freeBlocks << '\n';
+}
+
+
+/// Without size recovery the trace keeps every block with its size, with
+/// it only the pointers.
+template <class SizeRecovery, class Slot>
+struct SizeRecoveryTrace;
+
+template <class Slot>
+struct SizeRecoveryTrace<BitmappedBlock::NoSizeRecovery, Slot> {
+	static Slot makeSlot(RawBlock block) { return block; }
+
+	template <class Allocator>
+	static SizeType getExtraMemory(Allocator const &) { return 0; }
+};
+
+template <class Slot>
+struct SizeRecoveryTrace<BitmappedBlock::RunEndBitmap, Slot> {
+	static Slot makeSlot(RawBlock block) { return block.getPtr(); }
+
+	template <class Allocator>
+	static SizeType getExtraMemory(Allocator const & allocator) {
+		return allocator.getSizeRecovery().getMemoryUsage();
+	}
+};
+
+template <class SizeRecovery, class Slot>
+void runSizeRecoveryTrace(std::string const & name,
+                          std::vector<Instruction> const & trace,
+                          std::size_t iterations) {
+	using Allocator = BitmappedBlock::Runtime<
+		VectorSingle, 16, BitmappedBlock::NextFit, SizeRecovery>;
+
+	using Trace = SizeRecoveryTrace<SizeRecovery, Slot>;
+
+	constexpr SizeType blockSize  {16};
+	constexpr SizeType blockCount {1024 * 64};
+
+	std::size_t slotCount {0};
+	for (auto const & instruction : trace) {
+		if (instruction.slot >= slotCount)
+			slotCount = instruction.slot + 1;
+	}
+
+	std::ptrdiff_t totalTime   {0};
+	SizeType       extraMemory {0};
+
+	for (std::size_t iteration {0}; iteration < iterations; ++iteration) {
+		Allocator allocator {{blockSize, blockCount}};
+		std::vector<Slot> slots (slotCount, Trace::makeSlot({nullptr, 0}));
+
+		auto start = brh::getTime();
+
+		for (auto const & instruction : trace) {
+			auto & slot = slots[instruction.slot];
+
+			if (instruction.allocate)
+				slot = Trace::makeSlot(allocator.allocate(instruction.size));
+			else
+				allocator.deallocate(slot);
+		}
+
+		totalTime += brh::getTime() - start;
+
+		extraMemory = Trace::getExtraMemory(allocator);
+	}
+
+	std::cout << std::left << std::setw(18) << name << std::right <<
+		std::setw(12) << totalTime / static_cast<std::ptrdiff_t>(iterations) <<
+		std::setw(12) << sizeof(Slot) <<
+		std::setw(12) << extraMemory << '\n';
+}
+
+
+int main(int argc, char* argv[])
+{
+	constexpr std::size_t traceLength {200'000};
+	constexpr std::size_t maxLive     {2'000};
+	constexpr std::size_t iterations  {10};
+
+	auto trace = makeTrace(traceLength, maxLive);
+
+	std::cout << std::left << std::setw(18) << "Strategy" << std::right <<
+		std::setw(12) << "Time (us)" <<
+		std::setw(10) << "Failures" <<
+		std::setw(12) << "Ext. frag." <<
+		std::setw(10) << "Runs" <<
+		std::setw(10) << "Largest" <<
+		std::setw(10) << "Free" << '\n';
+
+	runTrace<BitmappedBlock::FirstFit>          ("First fit",     trace, iterations);
+	runTrace<BitmappedBlock::NextFit>           ("Next fit",      trace, iterations);
+	runTrace<BitmappedBlock::BestFit<4> >       ("Best fit (4)",  trace, iterations);
+	runTrace<BitmappedBlock::BestFit<16> >      ("Best fit (16)", trace, iterations);
+	runTrace<BitmappedBlock::SegregatedHints<> >("Segregated",    trace, iterations);
+
+	std::cout << '\n' << std::left << std::setw(18) << "Size recovery" <<
+		std::right <<
+		std::setw(12) << "Time (us)" <<
+		std::setw(12) << "Slot bytes" <<
+		std::setw(12) << "Extra bytes" << '\n';
+
+	runSizeRecoveryTrace<BitmappedBlock::NoSizeRecovery, RawBlock>(
+		"None", trace, iterations);
+	runSizeRecoveryTrace<BitmappedBlock::RunEndBitmap, void *>(
+		"Run end bitmap", trace, iterations);
+
+	return 0;
+}
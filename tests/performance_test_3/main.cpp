@@ -0,0 +1,109 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <thread>
+#include <atomic>
+#include <string>
+
+#include <allocators/bitmapped_block.h>
+#include <allocators/sharded_bitmapped_block.h>
+#include <allocators/per_cpu_cache_allocator.h>
+
+#include "../performance_test_0/get_time.h"
+
+using namespace brh::allocators;
+
+template <class T>
+using VectorSingle = std::vector<T>;
+
+
+constexpr SizeType blockSize  {16};
+constexpr SizeType blockCount {1024 * 8};
+
+/// Every thread keeps a few small blocks alive and writes to them between
+/// allocations, so that writes to the blocks compete with the meta data
+/// and mutex updates of the other threads.
+template <class Allocator>
+void work(Allocator & allocator, std::size_t operations) {
+	constexpr std::size_t liveCount {8};
+
+	std::array<RawBlock, liveCount> live;
+	live.fill(RawBlock::makeNullBlock());
+
+	for (std::size_t i {0}; i < operations; ++i) {
+		auto & block = live[i % liveCount];
+
+		allocator.deallocate(block);
+		block = allocator.allocate(blockSize * (1 + i % 3));
+
+		for (std::size_t j {0}; j < liveCount; ++j) {
+			if (!live[j].isNull())
+				++*static_cast<volatile char *>(live[j].getPtr());
+		}
+	}
+
+	for (auto block : live)
+		allocator.deallocate(block);
+}
+
+/// Every thread frees what it allocates, so the allocator can be reused.
+template <class Allocator>
+double run(Allocator & allocator,
+           std::size_t threadCount,
+           std::size_t operations) {
+	std::vector<std::thread> threads;
+	std::atomic<bool>        start {false};
+
+	for (std::size_t i {0}; i < threadCount; ++i) {
+		threads.emplace_back([&]() {
+			while (!start.load()) {}
+
+			work(allocator, operations);
+		});
+	}
+
+	auto begin = brh::getTime();
+	start.store(true);
+
+	for (auto & thread : threads)
+		thread.join();
+
+	auto time = brh::getTime() - begin;
+
+	// Operations per microsecond.
+	return static_cast<double>(threadCount * operations) / time;
+}
+
+
+int main(int argc, char* argv[])
+{
+	using Inline      = BitmappedBlock::Runtime<VectorSingle>;
+	using Partitioned = BitmappedBlock::Partitioned<VectorSingle>;
+	using Sharded     = ShardedBitmappedBlock::Runtime<VectorSingle>;
+	using PerCpu      = PerCpuCacheAllocator::Templated<Inline, blockSize * 3>;
+
+	constexpr std::size_t operations {100'000};
+
+	Inline      inlineAllocator      {{blockSize, blockCount}};
+	Partitioned partitionedAllocator {{blockSize, blockCount}};
+	Sharded     shardedAllocator     {blockSize, blockCount};
+	PerCpu      perCpuAllocator      {Inline({blockSize, blockCount})};
+
+	std::cout << std::left << std::setw(10) << "Threads" << std::right <<
+		std::setw(14) << "Inline" <<
+		std::setw(14) << "Partitioned" <<
+		std::setw(14) << "Sharded" <<
+		std::setw(14) << (perCpuAllocator.hasCpuCaches() ? "PerCpu" : "PerThread") <<
+		"   (operations/us)\n";
+
+	for (std::size_t threads : {2, 4, 8, 16, 32}) {
+		std::cout << std::left << std::setw(10) << threads << std::right <<
+			std::setw(14) << run(inlineAllocator,      threads, operations) <<
+			std::setw(14) << run(partitionedAllocator, threads, operations) <<
+			std::setw(14) << run(shardedAllocator,     threads, operations) <<
+			std::setw(14) << run(perCpuAllocator,      threads, operations) << '\n';
+	}
+
+	return 0;
+}
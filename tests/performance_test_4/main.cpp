@@ -0,0 +1,174 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <string>
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include <allocators/coroutine_frame_allocator.h>
+#include <allocators/bitmapped_block.h>
+
+#include "../performance_test_0/get_time.h"
+
+using namespace brh::allocators;
+
+template <class T>
+using VectorSingle = std::vector<T>;
+
+
+/// A lazily started coroutine that yields nothing but its completion.
+/// BasePromise decides where the frames come from.
+template <class BasePromise>
+class Task {
+	public:
+		struct promise_type : BasePromise {
+			Task get_return_object() {
+				return Task {Handle::from_promise(*this)};
+			}
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend()   noexcept { return {}; }
+
+			void return_value(int value) { result = value; }
+			void unhandled_exception() { std::terminate(); }
+
+			int result {0};
+		};
+
+		using Handle = std::coroutine_handle<promise_type>;
+
+		Task(Task && other) noexcept : handle_ {std::exchange(other.handle_, {})} {}
+
+		Task(Task const &) = delete;
+
+		~Task() {
+			if (handle_)
+				handle_.destroy();
+		}
+
+		int run() {
+			handle_.resume();
+			return handle_.promise().result;
+		}
+
+
+	private:
+		explicit Task(Handle handle) : handle_ {handle} {}
+
+		Handle handle_;
+};
+
+struct GlobalNew {};
+
+using GlobalTask = Task<GlobalNew>;
+using PooledTask = Task<CoroutineFrameAllocator::PooledPromise<> >;
+
+
+/// The buffer keeps the frame large enough to span size classes.
+template <class TaskType, std::size_t bufferSize>
+TaskType makeTask(int value) {
+	volatile char buffer[bufferSize];
+	buffer[value % bufferSize] = static_cast<char>(value);
+
+	co_return value + buffer[value % bufferSize];
+}
+
+template <class TaskType, std::size_t bufferSize, class Allocator>
+TaskType makeTask(std::allocator_arg_t, Allocator &, int value) {
+	volatile char buffer[bufferSize];
+	buffer[value % bufferSize] = static_cast<char>(value);
+
+	co_return value + buffer[value % bufferSize];
+}
+
+
+/// Keeps a batch of frames alive at a time so that the frames can't be
+/// elided into the caller.
+template <class MakeTask>
+long long churn(MakeTask makeOne, std::size_t batches, std::size_t batchSize) {
+	using TaskType = decltype(makeOne(0));
+
+	long long sum {0};
+	std::vector<TaskType> tasks;
+	tasks.reserve(batchSize);
+
+	for (std::size_t batch {0}; batch < batches; ++batch) {
+		for (std::size_t i {0}; i < batchSize; ++i)
+			tasks.push_back(makeOne(static_cast<int>(i)));
+
+		for (auto & task : tasks)
+			sum += task.run();
+
+		tasks.clear();
+	}
+
+	return sum;
+}
+
+template <class MakeTask>
+std::ptrdiff_t timeChurn(MakeTask makeOne, std::size_t threadCount,
+                         std::size_t batches, std::size_t batchSize) {
+	std::vector<std::thread> threads;
+
+	auto start = brh::getTime();
+
+	for (std::size_t i {0}; i < threadCount; ++i) {
+		threads.emplace_back([=]() {
+			volatile auto sum = churn(makeOne, batches, batchSize);
+			(void) sum;
+		});
+	}
+
+	for (auto & thread : threads)
+		thread.join();
+
+	return brh::getTime() - start;
+}
+
+template <std::size_t bufferSize>
+void compare(std::size_t threadCount, std::size_t batches, std::size_t batchSize) {
+	auto global = timeChurn([](int value) {
+		return makeTask<GlobalTask, bufferSize>(value);
+	}, threadCount, batches, batchSize);
+
+	auto pooled = timeChurn([](int value) {
+		return makeTask<PooledTask, bufferSize>(value);
+	}, threadCount, batches, batchSize);
+
+	std::cout << std::setw(10) << bufferSize <<
+		std::setw(10) << threadCount <<
+		std::setw(16) << global <<
+		std::setw(16) << pooled << '\n';
+}
+
+
+int main(int argc, char* argv[])
+{
+	constexpr std::size_t batches   {2'000};
+	constexpr std::size_t batchSize {256};
+
+	std::cout << std::setw(10) << "Buffer" <<
+		std::setw(10) << "Threads" <<
+		std::setw(16) << "Global (us)" <<
+		std::setw(16) << "Pooled (us)" << '\n';
+
+	for (std::size_t threadCount : {1, 4}) {
+		compare<16>  (threadCount, batches, batchSize);
+		compare<200> (threadCount, batches, batchSize);
+		compare<1000>(threadCount, batches, batchSize);
+	}
+
+	// Frames from an allocator passed to the coroutine.
+	BitmappedBlock::Runtime<VectorSingle> arena {{64, 1024 * 64}};
+
+	auto fromArena = churn([&arena](int value) {
+		return makeTask<PooledTask, 200>(std::allocator_arg, arena, value);
+	}, batches, batchSize);
+
+	std::cout << "\nArena frames " <<
+		(arena.isEmpty() ? "returned" : "leaked") << ' ' << fromArena << '\n';
+
+	return 0;
+}
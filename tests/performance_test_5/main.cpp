@@ -0,0 +1,254 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+#include <allocators/epoch_allocator.h>
+#include <allocators/full_free_list.h>
+#include <allocators/wrappers/allocator_wrapper.h>
+
+#include "../performance_test_0/get_time.h"
+
+using namespace brh::allocators;
+
+template <class T>
+using VectorSingle = std::vector<T>;
+
+
+struct Node {
+	Node * next;
+	long   value;
+};
+
+constexpr SizeType nodeCount {1024 * 64};
+
+using NodeAllocator = BlockAllocatorRegularInterface<
+	FullFreeList::Runtime<
+		VectorSingle, sizeof(Node), alignof(Node), FullFreeList::LockFree>
+>;
+
+
+/// A Treiber stack whose popped nodes are retired to an EpochAllocator.
+class EpochStack {
+	public:
+		EpochStack() : allocator_ (nodeCount) {}
+
+		bool push(long value) {
+			auto const block = allocator_.allocate(sizeof(Node));
+
+			if (block.isNull())
+				return false;
+
+			auto const node = new (block.getPtr()) Node {nullptr, value};
+			node->next = head_.load(std::memory_order_relaxed);
+
+			while (!head_.compare_exchange_weak(node->next, node,
+			                                    std::memory_order_release,
+			                                    std::memory_order_relaxed)) {}
+
+			return true;
+		}
+
+		bool pop(long & value) {
+			auto const guard = allocator_.pin();
+			auto top = head_.load(std::memory_order_acquire);
+
+			while (top != nullptr) {
+				if (head_.compare_exchange_weak(top, top->next,
+				                                std::memory_order_acquire,
+				                                std::memory_order_acquire)) {
+					value = top->value;
+					allocator_.retire({top, sizeof(Node)});
+
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+
+	private:
+		EpochAllocator<NodeAllocator> allocator_;
+		std::atomic<Node *>           head_ {nullptr};
+};
+
+
+/// The same stack with hazard pointers, one per thread. Retired nodes are
+/// scanned against all hazards once a thread has retired enough of them.
+class HazardStack {
+	public:
+		HazardStack() : allocator_ (nodeCount) {}
+
+		~HazardStack() {
+			for (auto & thread : retired_) {
+				for (auto node : thread)
+					allocator_.deallocate({node, sizeof(Node)});
+			}
+		}
+
+		bool push(long value) {
+			auto const block = allocator_.allocate(sizeof(Node));
+
+			if (block.isNull())
+				return false;
+
+			auto const node = new (block.getPtr()) Node {nullptr, value};
+			node->next = head_.load(std::memory_order_relaxed);
+
+			while (!head_.compare_exchange_weak(node->next, node,
+			                                    std::memory_order_release,
+			                                    std::memory_order_relaxed)) {}
+
+			return true;
+		}
+
+		bool pop(long & value, SizeType thread) {
+			auto & hazard = hazards_[thread].node;
+
+			while (true) {
+				auto top = head_.load(std::memory_order_acquire);
+
+				if (top == nullptr)
+					return false;
+
+				// The node is only safe to read once the hazard is visible
+				// and it is still on top.
+				hazard.store(top, std::memory_order_seq_cst);
+
+				if (head_.load(std::memory_order_seq_cst) != top)
+					continue;
+
+				if (head_.compare_exchange_strong(top, top->next,
+				                                  std::memory_order_acquire,
+				                                  std::memory_order_relaxed)) {
+					value = top->value;
+					hazard.store(nullptr, std::memory_order_release);
+					retire(top, thread);
+
+					return true;
+				}
+			}
+		}
+
+
+	private:
+		static constexpr SizeType maxThreads {64};
+
+		struct Hazard {
+			alignas(cacheLineSize) std::atomic<Node *> node {nullptr};
+		};
+
+		void retire(Node * node, SizeType thread) {
+			auto & retired = retired_[thread];
+			retired.push_back(node);
+
+			if (retired.size() < 2 * maxThreads)
+				return;
+
+			std::vector<Node *> protectedNodes;
+
+			for (auto const & hazard : hazards_) {
+				auto const hazardNode = hazard.node.load(std::memory_order_seq_cst);
+
+				if (hazardNode != nullptr)
+					protectedNodes.push_back(hazardNode);
+			}
+
+			std::sort(protectedNodes.begin(), protectedNodes.end());
+
+			auto kept = retired.begin();
+
+			for (auto retiredNode : retired) {
+				if (std::binary_search(protectedNodes.begin(),
+				                       protectedNodes.end(), retiredNode))
+					*kept++ = retiredNode;
+				else
+					allocator_.deallocate({retiredNode, sizeof(Node)});
+			}
+
+			retired.erase(kept, retired.end());
+		}
+
+		NodeAllocator                             allocator_;
+		std::atomic<Node *>                       head_ {nullptr};
+		std::array<Hazard, maxThreads>            hazards_;
+		std::array<std::vector<Node *>, maxThreads> retired_;
+};
+
+
+/// Every thread pushes and pops in turn and keeps count of what it got.
+template <class Stack, class Pop>
+double run(std::size_t threadCount, std::size_t operations, Pop pop) {
+	Stack                    stack;
+	std::vector<std::thread> threads;
+	std::atomic<bool>        start {false};
+	std::atomic<long>        balance {0};
+
+	for (std::size_t i {0}; i < threadCount; ++i) {
+		threads.emplace_back([&, i]() {
+			long pushed {0};
+			long popped {0};
+			long value;
+
+			while (!start.load()) {}
+
+			for (std::size_t j {0}; j < operations; ++j) {
+				if (j % 2 == 0)
+					pushed += stack.push(static_cast<long>(j));
+				else
+					popped += pop(stack, value, i);
+			}
+
+			balance += pushed - popped;
+		});
+	}
+
+	auto begin = brh::getTime();
+	start.store(true);
+
+	for (auto & thread : threads)
+		thread.join();
+
+	auto time = brh::getTime() - begin;
+
+	// Whatever is left on the stack was pushed and never popped.
+	long value;
+	while (pop(stack, value, 0))
+		--balance;
+
+	if (balance != 0)
+		std::cout << "Lost nodes: " << balance << '\n';
+
+	// Operations per microsecond.
+	return static_cast<double>(threadCount * operations) / time;
+}
+
+
+int main(int argc, char* argv[])
+{
+	constexpr std::size_t operations {1'000'000};
+
+	auto epochPop = [](EpochStack & stack, long & value, std::size_t) {
+		return stack.pop(value);
+	};
+
+	auto hazardPop = [](HazardStack & stack, long & value, std::size_t thread) {
+		return stack.pop(value, thread);
+	};
+
+	std::cout << std::left << std::setw(10) << "Threads" << std::right <<
+		std::setw(14) << "Epoch" <<
+		std::setw(14) << "Hazard" << "   (operations/us)\n";
+
+	for (std::size_t threads : {1, 2, 4, 8, 16}) {
+		std::cout << std::left << std::setw(10) << threads << std::right <<
+			std::setw(14) << run<EpochStack>(threads, operations, epochPop) <<
+			std::setw(14) << run<HazardStack>(threads, operations, hazardPop) << '\n';
+	}
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dlfcn.h>
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/// Runs the test again with the library preloaded, returns only if this
+/// process already has it.
+void preload(char * argv[]) {
+	auto const loaded = getenv("LD_PRELOAD");
+
+	if (loaded != nullptr && std::string(loaded) == BRH_PRELOAD_LIBRARY)
+		return;
+
+	setenv("LD_PRELOAD", BRH_PRELOAD_LIBRARY, 1);
+	execv("/proc/self/exe", argv);
+
+	std::cerr << "Could not run the test with the library preloaded\n";
+	std::exit(1);
+}
+
+/// Small, medium and large sizes of the default allocator.
+std::size_t pickSize(unsigned i) {
+	static std::size_t const sizes[] {8, 100, 256, 1000, 20000, 100000};
+
+	return sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+}
+
+/// Allocates, writes, checks and frees blocks of every size.
+void churn(unsigned seed, unsigned rounds) {
+	std::vector<char *> blocks;
+
+	for (unsigned i {0}; i < rounds; ++i) {
+		auto const size = pickSize(seed + i);
+		auto const ptr  = static_cast<char *>(malloc(size));
+
+		assert(ptr != nullptr);
+		std::memset(ptr, static_cast<char>(seed), size);
+		blocks.push_back(ptr);
+
+		if (blocks.size() == 16) {
+			for (auto block : blocks) {
+				assert(block[0] == static_cast<char>(seed));
+				free(block);
+			}
+
+			blocks.clear();
+		}
+	}
+
+	for (auto block : blocks)
+		free(block);
+}
+
+int main(int argc, char* argv[])
+{
+	preload(argv);
+
+	Dl_info info;
+	assert(dladdr(dlsym(RTLD_DEFAULT, "malloc"), &info) != 0);
+	assert(std::string(info.dli_fname) == BRH_PRELOAD_LIBRARY);
+
+	auto const pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+	// The functions without a replacement would reach the C library.
+	auto array = static_cast<int *>(reallocarray(nullptr, 100, sizeof(int)));
+	assert(array != nullptr);
+	assert(reallocarray(array, ~std::size_t {0} / pageSize, pageSize * 2) ==
+	       nullptr);
+	free(array);
+
+	auto const page = pvalloc(1);
+	assert(reinterpret_cast<std::uintptr_t>(page) % pageSize == 0);
+	assert(malloc_usable_size(page) >= pageSize);
+	free(page);
+
+	// Forking while other threads hold the allocator's locks must not
+	// leave them held in the child.
+	std::atomic<bool> running {true};
+	std::vector<std::thread> threads;
+
+	for (unsigned t {0}; t < 8; ++t) {
+		threads.emplace_back([&running, t] {
+			while (running.load())
+				churn(t, 1000);
+		});
+	}
+
+	for (unsigned i {0}; i < 50; ++i) {
+		auto const pid = fork();
+		assert(pid >= 0);
+
+		if (pid == 0) {
+			// A lock left held would hang the child.
+			alarm(10);
+
+			churn(i, 1000);
+
+			std::thread child {[i] { churn(i + 1, 1000); }};
+			child.join();
+
+			_exit(0);
+		}
+
+		int status;
+		assert(waitpid(pid, &status, 0) == pid);
+		assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+
+	running.store(false);
+
+	for (auto & thread : threads)
+		thread.join();
+
+	std::cout << "Passed" << std::endl;
+
+	return 0;
+}